@@ -0,0 +1,77 @@
+#include "CoSimulator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//Aggregate speed of 1, 2, 4... MCUs wired in a ring, each sending one byte to
+//the next over USART0 per 255 turns of a busy loop and reading what the
+//previous one sent. Linear scaling keeps the aggregate MHz growing with the MCU
+//count (up to the number of cores) and the efficiency near 1.
+//Usage: cosim_bench [simulated cycles per MCU, millions] [max MCUs]
+
+static const std::vector<uint16_t> FIRMWARE = {
+    0xECE0, // ldi r30,0xC0
+    0xE0F0, // ldi r31,0x00      Z = UCSR0A
+    0xEF8F, // outer: ldi r24,0xFF
+    0xE090, // ldi r25,0x00
+    0x0C01, // inner: add r0,r1
+    0x2423, // eor r2,r3
+    0x9701, // sbiw r24,1
+    0xF7E1, // brne inner
+    0x8206, // std Z+6,r0        send
+    0x8100, // ld r16,Z
+    0x7800, // andi r16,0x80     RXC0
+    0xF3B1, // breq outer
+    0x8116, // ldd r17,Z+6       receive
+    0xF7A7  // brid outer
+};
+
+struct Mcu {
+    SRAM sram;
+    CPU cpu;
+    Mcu(Flash* flash) : cpu(flash, &sram){}
+};
+
+static double runRing(Flash& flash, size_t count, uint64_t cycles){
+    std::vector<std::unique_ptr<Mcu>> mcus;
+    CoSimulator sim;
+    for(size_t i = 0; i < count; i++){
+        mcus.push_back(std::make_unique<Mcu>(&flash));
+        sim.addMcu(&mcus.back()->cpu);
+    }
+    uint64_t latency = Link::uartByteCycles(115200, 16000000);
+    for(size_t i = 0; i < count; i++){
+        sim.connect(i, (i + 1) % count, latency);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    sim.run(cycles);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char** argv){
+    uint64_t cycles = static_cast<uint64_t>(argc > 1 ? std::atof(argv[1]) * 1e6 : 16e6);
+    size_t maxMcus = static_cast<size_t>(argc > 2 ? std::atoi(argv[2]) : 4);
+    if(cycles == 0 || maxMcus == 0){
+        std::fprintf(stderr, "usage: %s [simulated Mcycles per MCU] [max MCUs]\n", argv[0]);
+        return 1;
+    }
+
+    Flash flash;
+    flash.load(FIRMWARE);
+
+    std::printf("%u hardware threads, %.1fM cycles per MCU\n", std::thread::hardware_concurrency(), cycles / 1e6);
+    std::printf("MCUs  wall s   aggregate MHz  speedup  efficiency\n");
+    double single = 0;
+    for(size_t count = 1; count <= maxMcus; count *= 2){
+        double seconds = runRing(flash, count, cycles);
+        double mhz = count * cycles / seconds / 1e6;
+        if(count == 1) single = mhz;
+        std::printf("%4zu  %7.3f  %13.1f  %7.2f  %10.2f\n", count, seconds, mhz, mhz / single, mhz / single / count);
+    }
+    return 0;
+}
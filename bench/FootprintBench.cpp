@@ -0,0 +1,13 @@
+#include "cpu.hpp"
+#include <cstdio>
+
+//Memory one emulated MCU costs, Flash excluded (instances running the same image share it)
+int main(){
+    std::printf("CPUState            %6zu bytes\n", sizeof(CPUState));
+    std::printf("CPUCold             %6zu bytes\n", sizeof(CPUCold));
+    std::printf("CPU                 %6zu bytes\n", sizeof(CPU));
+    std::printf("SRAM front end      %6zu bytes\n", sizeof(SRAM));
+    std::printf("bytes per instance  %6zu\n", CPU::BYTES_PER_INSTANCE);
+    std::printf("instances per GiB   %6zu\n", CPU::INSTANCES_PER_GIB);
+    return 0;
+}
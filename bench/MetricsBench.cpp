@@ -0,0 +1,115 @@
+#include "cpu.hpp"
+#include "RuntimeMetrics.hpp"
+#include "DecodeTable.hpp"
+#include "Fusion.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//Cost of CPU::run(cpu, metrics) over CPU::run(cpu). Each repetition runs the
+//same firmware through both loops back to back (order alternating) and keeps
+//the ratio, so drift between repetitions cancels out; the median ratio is the
+//overhead, reported with its standard error so it can be told from noise.
+//Usage: metrics_bench [repetitions] [outer iterations]
+
+//65535 turns of a five-instruction inner loop per outer iteration
+static std::vector<uint16_t> firmware(uint16_t outer){
+    std::vector<uint16_t> code = {
+        static_cast<uint16_t>(0xE020 | ((outer & 0xF0) << 4) | (outer & 0x0F)),        // ldi r18,lo(outer)
+        static_cast<uint16_t>(0xE030 | ((outer >> 4) & 0xF00) | ((outer >> 8) & 0x0F)), // ldi r19,hi(outer)
+        0xEF8F, // outer: ldi r24,0xFF
+        0xEF9F, // ldi r25,0xFF
+        0x0C01, // inner: add r0,r1
+        0x2423, // eor r2,r3
+        0x2C45, // mov r4,r5
+        0x9701, // sbiw r24,1
+        0xF7D9, // brne inner
+        0x5021, // subi r18,1
+        0x4030, // sbci r19,0
+        0xF7B1, // brne outer
+        0xE0E0, // ldi r30,0x00
+        0xE4F0, // ldi r31,0x40
+        0x9409  // ijmp              PC = WORDS: CPU::run stops
+    };
+    return code;
+}
+
+struct Sample {
+    double seconds;
+    uint64_t instructions;
+};
+
+static Sample runOnce(Flash& flash, DecodeTable& decode, MetricsSlot* slot){
+    SRAM sram;
+    CPU cpu(&flash, &sram);
+    FusionTable fusion;
+    fusion.build(flash);
+    cpu.setFusion(&fusion);
+    cpu.setDecodeTable(&decode);
+    RunMetrics metrics;
+    metrics.slot = slot;
+
+    auto start = std::chrono::steady_clock::now();
+    if(slot){
+        cpu.run(cpu, metrics);
+    }else{
+        cpu.run(cpu);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {elapsed.count(), cpu.getInstructions()};
+}
+
+static double quantile(std::vector<double> values, double q){
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(q * (values.size() - 1) + 0.5)];
+}
+
+int main(int argc, char** argv){
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 201;
+    uint16_t outer = static_cast<uint16_t>(argc > 2 ? std::atoi(argv[2]) : 1);
+    if(repetitions < 1 || outer < 1){
+        std::fprintf(stderr, "usage: %s [repetitions] [outer iterations]\n", argv[0]);
+        return 1;
+    }
+
+    Flash flash;
+    flash.load(firmware(outer));
+    InstructionDecoder decoder;
+    DecodeTable decode;
+    decode.build(flash, decoder);
+    MetricsRegistry registry;
+    MetricsSlot* slot = registry.add("bench");
+
+    std::vector<double> plain, withMetrics, ratios;
+    uint64_t instructions = runOnce(flash, decode, nullptr).instructions; //Warm-up
+    for(int i = 0; i < repetitions; i++){
+        Sample a, b;
+        if(i % 2 == 0){
+            a = runOnce(flash, decode, nullptr);
+            b = runOnce(flash, decode, slot);
+        }else{
+            b = runOnce(flash, decode, slot);
+            a = runOnce(flash, decode, nullptr);
+        }
+        plain.push_back(a.seconds);
+        withMetrics.push_back(b.seconds);
+        ratios.push_back(b.seconds / a.seconds);
+    }
+
+    double plainMedian = quantile(plain, 0.5);
+    double metricsMedian = quantile(withMetrics, 0.5);
+    double overhead = (quantile(ratios, 0.5) - 1) * 100;
+    double noise = (quantile(ratios, 0.75) - quantile(ratios, 0.25)) * 100;
+    //Standard error of a median, with the spread estimated from the IQR
+    double error = 1.2533 * (noise / 1.349) / std::sqrt(static_cast<double>(repetitions));
+
+    std::printf("%llu instructions per run, %d paired runs\n", static_cast<unsigned long long>(instructions), repetitions);
+    std::printf("run            median %.4f s  %.1f MIPS\n", plainMedian, instructions / plainMedian / 1e6);
+    std::printf("run + metrics  median %.4f s  %.1f MIPS\n", metricsMedian, instructions / metricsMedian / 1e6);
+    std::printf("overhead       %+.2f%% +/- %.2f%% (paired median, standard error)\n", overhead, error);
+    std::printf("noise          %.2f%% (interquartile range of the ratio)\n", noise);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Flash.hpp"
+
+static constexpr uint16_t NO_TARGET = 0xFFFF;
+static constexpr size_t VECTORS = 26; //Reset + 25 interrupts, two words each
+
+enum class BlockExit : uint8_t {
+    FallThrough, //Next word starts another block
+    Branch,      //Conditional branch: taken or next
+    Skip,        //CPSE/SBRC/SBRS/SBIC/SBIS: taken skips the following instruction
+    Jump,
+    Call,        //taken = callee, next = return address
+    Return,
+    Indirect,    //IJMP/EIJMP, target unknown
+    End          //Runs off the analysed image
+};
+
+struct BasicBlock {
+    uint16_t start;        //First word
+    uint16_t end;          //One past the last word
+    uint16_t taken;
+    uint16_t next;
+    uint16_t instructions;
+    BlockExit exit;
+    bool idle;             //Jumps to itself doing nothing but NOP/SLEEP
+};
+
+//Counted loop: LDI of the counter before the head, DEC/SUBI 1/SBIW 1 + BRNE at the end
+struct CountedLoop {
+    uint16_t head;
+    uint16_t branch;
+    uint8_t reg;           //Counter register (low register of the pair for SBIW)
+    uint32_t iterations;
+};
+
+//Static control-flow graph of the reachable code, built once per Flash::load from
+//the raw words. Unreachable words (data, padding) belong to no block.
+class ControlFlowGraph{
+
+    private:
+        std::vector<BasicBlock> blocks; //Sorted by start
+        std::vector<uint16_t> blockIndex; //Per word, NO_TARGET outside any block
+        std::bitset<WORDS> starts;
+        std::bitset<WORDS> secondWords;
+        std::vector<uint16_t> callTargets;
+        std::vector<CountedLoop> loops;
+        size_t instructionCount;
+
+        void findLoops(const uint16_t* words);
+
+    public:
+        ControlFlowGraph();
+        void build(const uint16_t* words, size_t count);
+        void clear();
+
+        const BasicBlock* blockAt(uint16_t pc) const{
+            if(pc >= blockIndex.size() || blockIndex[pc] == NO_TARGET){
+                return nullptr;
+            }
+            return &blocks[blockIndex[pc]];
+        }
+
+        bool isInstructionStart(uint16_t pc) const;
+        bool isSecondWord(uint16_t pc) const;
+        bool isIdleLoop(uint16_t pc) const;
+        const CountedLoop* loopAt(uint16_t head) const;
+        size_t getInstructionCount() const;
+        const std::vector<BasicBlock>& getBlocks() const;
+        const std::vector<uint16_t>& getCallTargets() const;
+        const std::vector<CountedLoop>& getLoops() const;
+
+        static uint8_t length(uint16_t opcode);
+};
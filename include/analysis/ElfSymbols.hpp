@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ElfSymbol {
+    std::string name;
+    uint32_t address; //Flash symbols: word address, data symbols: data-space address
+    uint32_t size;    //Bytes, as in the symbol table
+    bool function;
+};
+
+//Symbol table of an avr-gcc ELF, used to put names on addresses in reports
+class ElfSymbols{
+
+    private:
+        std::vector<ElfSymbol> functions; //Sorted by address
+        std::vector<ElfSymbol> objects;
+
+    public:
+        void load(const std::string& path);
+        const ElfSymbol* functionAt(uint16_t pc) const;
+        const ElfSymbol* find(const std::string& name) const;
+        const std::vector<ElfSymbol>& getFunctions() const;
+};
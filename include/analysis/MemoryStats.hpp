@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SRAM.hpp"
+
+class ElfSymbols;
+
+static constexpr size_t PAGE_BYTES = 256;
+static constexpr size_t PAGES = (SIZE + PAGE_BYTES - 1) / PAGE_BYTES;
+
+struct FirstWrite {
+    uint16_t address;
+    uint64_t cycle;
+};
+
+struct StackLow {
+    uint16_t pc;
+    uint16_t sp;
+};
+
+//Stack and data-space usage, fed from the SRAM access path. Nothing is
+//collected unless an instance is attached (CPU::setMemoryStats), so the cost
+//when disabled is one pointer test per data access.
+class MemoryStats{
+
+    private:
+        const uint16_t* pc;
+        const uint64_t* clock;
+        std::array<uint64_t,PAGES> reads;
+        std::array<uint64_t,PAGES> writes;
+        std::bitset<SIZE> written;
+        std::vector<FirstWrite> firstWrites;
+        uint16_t spLow;
+        uint16_t spLowPc;
+        std::vector<StackLow> stackLows; //One per new low-water mark, deepest last
+        void firstWrite(uint16_t addr);
+        void newStackLow(uint16_t sp);
+
+    public:
+        MemoryStats();
+        void bind(const uint16_t* pc, const uint64_t* clock);
+        void clear();
+
+        void onRead(uint16_t addr){
+            reads[addr / PAGE_BYTES]++;
+        }
+
+        void onWrite(uint16_t addr){
+            writes[addr / PAGE_BYTES]++;
+            if(!written[addr]){
+                firstWrite(addr);
+            }
+        }
+
+        //Runs on every PUSH and CALL; only a new low-water mark costs more than
+        //a compare. Values below SRAM (SP not set up yet) are ignored.
+        void onStackPointer(uint16_t sp){
+            if(sp < spLow && sp >= IO_END){
+                newStackLow(sp);
+            }
+        }
+
+        uint16_t getStackLow() const;
+        uint16_t getPeakStackDepth() const;
+        uint64_t getReads(size_t page) const;
+        uint64_t getWrites(size_t page) const;
+        bool wasWritten(uint16_t addr) const;
+        const std::vector<FirstWrite>& getFirstWrites() const;
+        const std::vector<StackLow>& getStackLows() const;
+        std::string report(const ElfSymbols* symbols = nullptr) const;
+};
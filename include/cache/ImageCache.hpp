@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "Flash.hpp"
+#include "InstructionDecoder.hpp"
+#include "DecodeTable.hpp"
+#include "Fusion.hpp"
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t words;
+    uint64_t imageHash;
+    uint64_t buildId;
+    uint64_t decodeOffset;
+    uint64_t fusionIndexOffset;
+    uint64_t fusionOpsOffset;
+    uint64_t fusionOpsCount;
+    uint64_t totalSize;
+};
+
+//Keeps the per-image analysis (decode table, fusion decisions) on disk, keyed by
+//the Flash contents and the emulator build, and maps it back instead of redoing it
+class ImageCache{
+
+    private:
+        struct Mapping {
+            void* addr;
+            size_t size;
+        };
+
+        std::string directory;
+        std::unordered_map<const DecodeTable*, Mapping> mappings; //One per table owner
+
+        void adopt(const DecodeTable& owner, Mapping mapping);
+        std::string pathFor(uint64_t imageHash) const;
+        bool load(const std::string& path, uint64_t imageHash, DecodeTable& decode, FusionTable& fusion);
+        void store(const std::string& path, uint64_t imageHash, const DecodeTable& decode, const FusionTable& fusion);
+
+    public:
+        ImageCache(const std::string& directory);
+        ~ImageCache();
+        ImageCache(const ImageCache&) = delete;
+        ImageCache& operator=(const ImageCache&) = delete;
+
+        bool prepare(const Flash& flash, const InstructionDecoder& decoder, DecodeTable& decode, FusionTable& fusion);
+        size_t mappedImages() const;
+
+        static uint64_t imageHash(const Flash& flash);
+        static uint64_t buildId();
+};
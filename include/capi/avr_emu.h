@@ -0,0 +1,70 @@
+#ifndef AVR_EMU_H
+#define AVR_EMU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define AVR_API __declspec(dllexport)
+#else
+#define AVR_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AVR_NUM_REGS 32
+#define AVR_DATA_SIZE 2304
+#define AVR_FLASH_WORDS 16384
+
+typedef struct avr_emu avr_emu;
+
+typedef enum {
+    AVR_OK = 0,
+    AVR_HIT_PC = 1,
+    AVR_STOPPED = 2,
+    AVR_ILLEGAL_OPCODE = -1,
+    AVR_MEMORY_FAULT = -2
+} avr_status;
+
+/* Return nonzero from a write callback to stop the current run_* call */
+typedef int (*avr_io_write_cb)(void* user, uint16_t addr, uint8_t value, uint64_t cycle);
+typedef uint8_t (*avr_io_read_cb)(void* user, uint16_t addr, uint64_t cycle);
+
+AVR_API avr_emu* avr_create(void);
+AVR_API void avr_destroy(avr_emu* emu);
+/* Keeps decoded images in dir and maps them back on later loads of the same
+   firmware; set once, before the first avr_load_flash. Defaults to
+   $AVR_EMU_CACHE_DIR when that is set. */
+AVR_API int avr_set_cache_dir(avr_emu* emu, const char* dir);
+AVR_API int avr_load_flash(avr_emu* emu, const uint16_t* words, size_t count);
+/* Call after patching Flash through avr_flash and before the next run_* call:
+   the decode table, fused sequences and the control-flow graph are derived
+   from the image */
+AVR_API int avr_flash_changed(avr_emu* emu);
+AVR_API void avr_reset(avr_emu* emu);
+
+/* Batched entry points: one call runs many instructions */
+AVR_API avr_status avr_run_cycles(avr_emu* emu, uint64_t cycles);
+AVR_API avr_status avr_run_until_pc(avr_emu* emu, uint16_t pc, uint64_t max_cycles);
+AVR_API uint64_t avr_cycles(avr_emu* emu);
+AVR_API const char* avr_last_error(avr_emu* emu);
+
+/* Live views into the emulator state, valid until avr_destroy */
+AVR_API uint8_t* avr_regs(avr_emu* emu);
+AVR_API uint8_t* avr_sreg(avr_emu* emu);
+AVR_API uint16_t* avr_pc(avr_emu* emu);
+/* r0-r31, SREG and SPL/SPH live in the views above; their bytes in avr_data are unused */
+AVR_API uint8_t* avr_data(avr_emu* emu);
+AVR_API uint16_t* avr_flash(avr_emu* emu); /* See avr_flash_changed */
+
+/* Routes reads/writes of I/O addresses [first, last] to the host; set once */
+AVR_API int avr_set_io_callbacks(avr_emu* emu, uint16_t first, uint16_t last,
+                                 avr_io_read_cb read, avr_io_write_cb write, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
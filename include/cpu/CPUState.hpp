@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "RegistersFile.hpp"
+#include "StatusRegister.hpp"
+#include "ProgramCounter.hpp"
+#include "SRAM.hpp"
+
+static constexpr uint16_t RAMEND = 0x08FF;
+
+//Everything an instruction reads or writes, in one block: registers, SREG, PC,
+//SP and the cycle and instruction counters share the first cache line and the data space starts
+//on the next one. Trivially copyable, so a snapshot is a plain memcpy.
+struct alignas(64) CPUState {
+    RegisterFile regs;
+    StatusRegister sr;
+    ProgramCounter pc;
+    uint16_t sp;
+    uint64_t cycles;
+    uint64_t instructions; //Retired; a fused sequence counts each of its instructions
+    alignas(64) std::array<uint8_t,SIZE> data;
+};
+
+static_assert(std::is_trivially_copyable<CPUState>::value, "CPUState must stay memcpy-able");
+static_assert(offsetof(CPUState, instructions) + sizeof(uint64_t) <= 64, "Hot registers must fit one cache line");
+static_assert(offsetof(CPUState, data) == 64, "Data space must follow the hot line");
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Flash.hpp"
+#include "InstructionDecoder.hpp"
+
+//Decoder table index for every Flash word, so a step skips the pattern search.
+//Either owns its entries or views a cached copy (see ImageCache).
+class DecodeTable{
+
+    private:
+        std::vector<uint8_t> entries;
+        const uint8_t* view;
+
+    public:
+        DecodeTable();
+        void build(const Flash& flash, const InstructionDecoder& decoder);
+        void attach(const uint8_t* entries);
+        const uint8_t* data() const;
+
+        uint8_t at(uint16_t addr) const{
+            return view[addr];
+        }
+};
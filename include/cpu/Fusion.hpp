@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "Flash.hpp"
+
+class CPU;
+
+enum class FusedKind : uint8_t {
+    None,
+    LdiPair,      //LDI Rd,K ; LDI Rd+1,K
+    SubiSbci,     //SUBI Rd,K ; SBCI Rd+1,K
+    CpCpcBranch,  //CP Rd,Rr ; CPC Rd+1,Rr+1 ; BRBS/BRBC
+    SbiwBrne      //SBIW Rd,K ; BRNE
+};
+
+//Operands are extracted once at build time, so running a fused op touches
+//neither Flash nor the decoder table
+struct FusedOp {
+    FusedKind kind;
+    uint8_t length;   //Instructions (and words) covered
+    uint8_t maxCycles;
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t bit;
+    bool whenSet;
+    int8_t offset;
+};
+
+static_assert(std::is_trivially_copyable<FusedOp>::value, "FusedOp is stored raw in the image cache");
+
+//Cached fusion tables are only valid for the matcher that built them; bump
+//whenever match() or the meaning of a FusedOp field changes
+static constexpr uint32_t FUSION_FORMAT = 2;
+
+//Superinstructions for the fixed sequences avr-gcc emits. Each fused handler
+//performs the same ALU calls as the single-step path, in the same order, so
+//registers, SREG and cycle counts match exactly. Must be rebuilt if Flash changes
+//(avr_flash_changed in the C API).
+class FusionTable{
+
+    private:
+        std::vector<uint16_t> index; //Per Flash word, 0 = nothing fused here
+        std::vector<FusedOp> ops;
+        const uint16_t* indexView;
+        const FusedOp* opsView;
+        size_t opsCount;
+
+    public:
+        FusionTable();
+        void build(const Flash& flash);
+        void clear();
+        void attach(const uint16_t* index, const FusedOp* ops, size_t count);
+        const FusedOp* at(uint16_t addr) const;
+        size_t count() const;
+        const uint16_t* indexData() const;
+        const FusedOp* opsData() const;
+        uint8_t execute(const FusedOp& op, CPU& cpu) const;
+
+        static FusedOp match(uint16_t first, uint16_t second, uint16_t third);
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <string>
 #include <functional>
@@ -6,6 +7,7 @@
 struct Instruction {
     uint16_t opcode;
     std::string mnemonic;
-    std::vector<uint8_t> operands;
+    std::array<uint8_t,2> operands = {0, 0};
     std::function<void()> execute;
+    uint8_t cycles = 1;
 };
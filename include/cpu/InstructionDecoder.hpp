@@ -1,8 +1,18 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include "Instruction.hpp"
 
+class CPU;
+
+static constexpr uint8_t NOT_DECODED = 0xFF;
+
 class InstructionDecoder {
 public:
-    Instruction decode(uint16_t opcode, CPU cpu);
+    Instruction decode(uint16_t opcode, CPU& cpu);
+    Instruction decodeIndexed(uint8_t index, uint16_t opcode, CPU& cpu);
+    uint8_t lookup(uint16_t opcode) const;
+    bool accepts(uint16_t opcode) const;
+    size_t entries() const;
+    bool entryAt(uint8_t index, uint16_t& mask, uint16_t& pattern) const;
 };
@@ -12,10 +12,10 @@ class ProgramCounter {
         void set(uint16_t value);
         void increment();
         void decrement();
+        uint16_t* data();
 
         ProgramCounter();
         ProgramCounter(uint16_t initialValue);
-        ProgramCounter(const ProgramCounter& other);
 
 
 };
\ No newline at end of file
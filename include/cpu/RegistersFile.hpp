@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 class RegisterFile {
@@ -11,6 +12,7 @@ public:
     uint8_t read(size_t index) const;
     void write(size_t index, uint8_t value);
     void clear();
+    uint8_t* data();
 
 private:
     std::array<uint8_t, NUM_REGS> regs;
@@ -15,4 +15,5 @@ public:
     bool getFlag(uint8_t mask);
     uint8_t get();
     void set(uint8_t val);
+    uint8_t* data();
 };
@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+#include <bitset>
+#include <memory>
 #include <cstdint>
 #include <string>
 #include "ProgramCounter.hpp"
@@ -9,29 +11,79 @@
 #include "InstructionDecoder.hpp"
 #include "Flash.hpp"
 #include "SRAM.hpp"
+#include "Fusion.hpp"
+#include "DecodeTable.hpp"
+#include "CPUState.hpp"
+
+class Coverage;
+class MemoryStats;
+struct RunMetrics;
+
+//Per-instance data the instruction path rarely touches
+struct CPUCold {
+    Flash* flash;
+    SRAM* sram;
+    Coverage* coverage;
+    FusionTable* fusion;
+    DecodeTable* decodeTable;
+    uint64_t decodeLookups; //Single steps; fused sequences need no decoding
+    uint64_t decodeHits;    //Single steps the decode table answered
+    std::unique_ptr<std::bitset<WORDS>> breakpoints; //Allocated on first use
+    uint64_t instructionLimit; //Fused sequences must not run past it (see runInstructions)
+};
 
 class CPU {
 
 private:
+    CPUState state;
+    CPUCold cold;
     ALU alu;
     InstructionDecoder instrcutionDecoder;
-    RegisterFile regs;
-    StatusRegister sr;
-    ProgramCounter pc;
-
-    Flash* flash;
-    SRAM* sram;
-    
 
+    bool canFuse(const FusedOp& op);
 
 public:
+    using Snapshot = CPUState;
+
+    //CPU plus its data-space front end; Flash is shared by instances running the same image.
+    //Defined after the class, sizeof(CPU) needs it complete
+    static const size_t BYTES_PER_INSTANCE;
+    static const size_t INSTANCES_PER_GIB;
+
     CPU(Flash* flash,SRAM* sram);
+    CPU(const CPU&) = delete;
+    CPU& operator=(const CPU&) = delete;
     void reset();
-    void step(CPU cpu);
-    void run(CPU cpu);
-    ALU getAlu();
-    InstructionDecoder getInstructionDecoder();
-    RegisterFile getRegisterFile();
-    ProgramCounter getProgramCounter();
-    StatusRegister getStatusRegister();
+    void step(CPU& cpu);
+    void run(CPU& cpu);
+    void run(CPU& cpu, RunMetrics& metrics);
+    uint64_t runInstructions(CPU& cpu, uint64_t count);
+    ALU& getAlu();
+    InstructionDecoder& getInstructionDecoder();
+    RegisterFile& getRegisterFile();
+    ProgramCounter& getProgramCounter();
+    StatusRegister& getStatusRegister();
+    SRAM& getSRAM();
+    CPUState& getState();
+    uint64_t getCycles();
+    uint64_t getInstructions();
+    uint64_t getDecodeLookups();
+    uint64_t getDecodeHits();
+    uint16_t getStackPointer();
+    Coverage* getCoverage();
+    void setCoverage(Coverage* coverage);
+    Snapshot snapshot();
+    void restore(const Snapshot& snapshot);
+    void addCycles(uint8_t extra);
+    FusionTable* getFusion();
+    void setFusion(FusionTable* fusion);
+    DecodeTable* getDecodeTable();
+    void setDecodeTable(DecodeTable* decodeTable);
+    void setBreakpoint(uint16_t addr, bool enabled);
+    bool hasBreakpoint(uint16_t addr);
+    void setMemoryStats(MemoryStats* stats);
 };
+
+//sizeof(CPU) rather than the sum of its members, so alignment padding is counted
+inline constexpr size_t CPU::BYTES_PER_INSTANCE = sizeof(CPU) + sizeof(SRAM);
+inline constexpr size_t CPU::INSTANCES_PER_GIB = (size_t(1) << 30) / CPU::BYTES_PER_INSTANCE;
@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+static constexpr size_t MAP_SIZE = 65536; //Same size as AFL's default __AFL_SHM_ID region
+
+class Coverage{
+
+    private:
+        std::array<uint8_t,MAP_SIZE> localMap;
+        uint8_t* map;
+        uint16_t prevLoc;
+        void* shared;
+
+    public:
+        Coverage();
+        ~Coverage();
+        bool attachShared();
+        void resetLocation();
+        void clear();
+        size_t countEdges() const;
+        uint8_t* getMap();
+
+        //AFL-style edge: hash of the branch target xor'd with the previous location
+        inline void edge(uint16_t target){
+            uint16_t cur = static_cast<uint16_t>(target * 0x9E37u);
+            map[cur ^ prevLoc]++;
+            prevLoc = cur >> 1;
+        }
+};
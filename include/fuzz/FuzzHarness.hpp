@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "cpu.hpp"
+#include "Coverage.hpp"
+#include "Usart.hpp"
+
+enum class FuzzResult{
+    Ok,
+    IllegalOpcode,
+    MemoryFault,
+    Timeout,
+    StackFault
+};
+
+class FuzzHarness{
+
+    private:
+        CPU* cpu;
+        Coverage* coverage;
+        CPU::Snapshot snapshot;
+        std::vector<std::unique_ptr<IoDevice>> devices; //Peripheral state that goes with snapshot
+        std::deque<uint8_t> rxBuffer;
+        Usart usart; //Firmware reads the input from UDR0
+        uint64_t watchdogCycles;
+        uint64_t drainCycles;
+        uint64_t executions;
+        std::chrono::steady_clock::time_point started;
+
+    public:
+        FuzzHarness(CPU* cpu, Coverage* coverage, uint64_t watchdogCycles, uint64_t drainCycles);
+        ~FuzzHarness();
+        FuzzHarness(const FuzzHarness&) = delete;
+        FuzzHarness& operator=(const FuzzHarness&) = delete;
+        void boot(uint64_t cycles);
+        FuzzResult runOne(const uint8_t* data, size_t size);
+        uint64_t runPersistent(const std::function<bool(std::vector<uint8_t>&)>& nextInput, bool abortOnCrash);
+
+        bool rxAvailable() const;
+        uint8_t rxRead();
+
+        uint64_t getExecutions() const;
+        double execsPerSecond() const;
+};
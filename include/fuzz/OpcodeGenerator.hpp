@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "InstructionDecoder.hpp"
+
+//Start-up code in front of every generated program: X, Y and Z point into
+//SRAM and SP leaves 256 bytes above it, so the first loads, stores, pushes
+//and pops hit memory
+static constexpr uint16_t PROLOGUE[] = {
+    0xE0A0, 0xE0B2, // ldi r26,0x00 ; ldi r27,0x02   X = 0x0200
+    0xE0C0, 0xE0D4, // ldi r28,0x00 ; ldi r29,0x04   Y = 0x0400
+    0xE0E0, 0xE0F6, // ldi r30,0x00 ; ldi r31,0x06   Z = 0x0600
+    0xE007, 0xBF0E, // ldi r16,0x07 ; out SPH,r16
+    0xEF0F, 0xBF0D  // ldi r16,0xFF ; out SPL,r16    SP = 0x07FF
+};
+static constexpr size_t PROLOGUE_WORDS = sizeof(PROLOGUE) / sizeof(PROLOGUE[0]);
+
+//Random instruction words drawn from the decoder table: an entry is picked
+//uniformly and its free bits filled at random. Words that an earlier entry
+//would claim, or that the entry's decoder refuses (reserved LD/ST modes), are
+//redrawn, so every entry is exercised through its own decoder.
+class OpcodeGenerator{
+
+    private:
+        const InstructionDecoder* decoder;
+        std::mt19937 rng;
+        std::vector<uint8_t> indices;
+        std::vector<uint16_t> masks;
+        std::vector<uint16_t> patterns;
+
+    public:
+        OpcodeGenerator(const InstructionDecoder* decoder, uint32_t seed);
+        uint16_t next();
+        std::vector<uint16_t> program(size_t words);
+};
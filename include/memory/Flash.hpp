@@ -3,19 +3,28 @@
 #include<cstdint>
 #include<stdexcept>
 #include<iostream>
+#include <memory>
 #include <vector>
 
 static constexpr size_t WORDS = 16384;
+
+class ControlFlowGraph;
+
 class Flash{
 
     private:
         std::array<uint16_t,WORDS> mem;
+        std::shared_ptr<const ControlFlowGraph> cfg; //Rebuilt by load/analyze, shared by copies
+        size_t programWords; //Extent of the image, grown by writes past it
     
     public:
         Flash();
         void load(const std::vector<uint16_t>& program);
+        void analyze();
         uint16_t read(uint16_t address) const;
         void write(uint16_t addr, uint16_t val);
         size_t size() const;
+        uint16_t* data();
+        const ControlFlowGraph* getCfg() const;
 
 };
\ No newline at end of file
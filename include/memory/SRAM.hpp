@@ -1,23 +1,62 @@
 #pragma once
 #include<array>
 #include<cstdint>
+#include<memory>
 #include<stdexcept>
-#include "RegistersFile.hpp"
-#include "StatusRegister.hpp"
+#include<vector>
+#include "IoDevice.hpp"
+
+class MemoryStats;
 
 
 static constexpr size_t SIZE = 2304; //0x0000 - 0x08FF
+static constexpr uint16_t IO_START = 0x0020;
+static constexpr uint16_t IO_END = 0x0100; //Standard + extended I/O
+static constexpr uint16_t SPL = 0x005D;
+static constexpr uint16_t SPH = 0x005E;
+static constexpr uint16_t SREG = 0x005F;
+
+//Data space access path. The bytes themselves live in the owning CPU's state
+//(see bind); a standalone SRAM keeps its own until it is bound. Registers, SREG
+//and SP are aliased to the CPU's copies, so their bytes in the array are unused.
 class SRAM{
     private:
-        std::array<uint8_t,SIZE> mem;
-        RegisterFile regs;
-        StatusRegister sr;
+        uint8_t* mem;
+        uint8_t* regs; //r0-r31 at 0x00-0x1F
+        uint8_t* sreg;
+        uint16_t* sp;
+        std::unique_ptr<uint8_t[]> own;
+        uint16_t ownSp;
+        std::array<uint8_t,IO_END - IO_START> io; //1-based index into devices, 0 = plain memory
+        std::vector<IoDevice*> devices;
+        const uint64_t* clock;
+        uint64_t deadline;
+        MemoryStats* stats; //Null unless usage analytics are on
+        void updateDeadline();
     public:
         SRAM();
+        SRAM(const SRAM&) = delete;
+        SRAM& operator=(const SRAM&) = delete;
+        void bind(uint8_t* data, uint8_t* regs, uint8_t* sreg, uint16_t* sp);
         uint8_t read(uint16_t addr) const;
         void write(uint16_t addr, uint8_t val);
+        void push(uint8_t val);
+        uint8_t pop();
         uint8_t readSRAM(uint16_t addr) const;
-        RegisterFile& getRegs();
-        StatusRegister& getStatusRegister();
         std::array<uint8_t,SIZE> getMem();
-};
\ No newline at end of file
+        uint8_t* data();
+        void attach(uint16_t addr, IoDevice* device);
+        void addDevice(IoDevice* device);
+        void detach(IoDevice* device);
+        void setClock(const uint64_t* clock);
+        void syncDevices(uint64_t now);
+        void resetDevices();
+        void rebaseDevices(uint64_t now);
+        std::vector<std::unique_ptr<IoDevice>> saveDevices() const;
+        void restoreDevices(const std::vector<std::unique_ptr<IoDevice>>& saved);
+        void setStats(MemoryStats* stats);
+
+        uint64_t getDeadline() const{
+            return deadline;
+        }
+};
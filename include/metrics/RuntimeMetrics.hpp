@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PinEventRing;
+
+//Steps per idle sample and between flushes of the run-loop counters into the slot
+static constexpr uint32_t METRICS_SAMPLE = 256;
+static constexpr uint32_t METRICS_FLUSH = 4096;
+
+//One run thread's counters on a cache line of their own. Only the owning thread
+//stores and only the publisher loads, both relaxed, so no read-modify-write
+//ever reaches the bus.
+struct alignas(64) MetricsSlot {
+    std::atomic<uint64_t> instructions{0};
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> idleCycles{0};
+    std::atomic<uint64_t> decodeHits{0};
+    std::atomic<uint64_t> decodeLookups{0};
+    std::atomic<uint64_t> pendingInterrupts{0};
+    std::atomic<uint64_t> traceDrops{0};
+};
+
+static_assert(sizeof(MetricsSlot) == 64, "MetricsSlot must fill exactly one cache line");
+
+//Run-loop side of a slot: plain counters, copied into the slot by flush()
+struct RunMetrics {
+    MetricsSlot* slot = nullptr;
+    uint64_t idleCycles = 0;
+    std::vector<std::function<bool()>> interruptSources; //e.g. [&]{ return timer.interruptPending(); }
+    const PinEventRing* trace = nullptr;
+
+    void flush(uint64_t instructions, uint64_t cycles, uint64_t decodeLookups, uint64_t decodeHits);
+};
+
+//Owns the slots and periodically writes them out in text exposition format,
+//through a temporary file and a rename so a scraper never reads a partial file
+class MetricsRegistry{
+
+    private:
+        struct Entry {
+            std::string name;
+            std::unique_ptr<MetricsSlot> slot;
+            uint64_t lastInstructions;
+        };
+
+        std::mutex lock;
+        std::vector<Entry> entries;
+        std::string path;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point lastRender;
+        std::thread thread;
+        std::atomic<bool> running;
+
+        void loop();
+        void tryPublish();
+
+    public:
+        MetricsRegistry();
+        ~MetricsRegistry();
+        MetricsRegistry(const MetricsRegistry&) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+        MetricsSlot* add(const std::string& name);
+        std::string render();
+        void publish();
+        void start(const std::string& path, std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+        void stop();
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "IoDevice.hpp"
+
+class SRAM;
+
+static constexpr uint16_t ADCL = 0x78;
+static constexpr uint16_t ADCH = 0x79;
+static constexpr uint16_t ADCSRA = 0x7A;
+static constexpr uint16_t ADCSRB = 0x7B;
+static constexpr uint16_t ADMUX = 0x7C;
+
+static constexpr uint8_t ADEN = 0x80;
+static constexpr uint8_t ADSC = 0x40;
+static constexpr uint8_t ADATE = 0x20;
+static constexpr uint8_t ADIF = 0x10;
+static constexpr uint8_t ADIE = 0x08;
+
+static constexpr size_t ADC_CHANNELS = 16;
+
+//Conversions are not clocked: starting one records when it will be done and the
+//result is filled in the first time ADCSRA/ADCL/ADCH is read after that.
+class Adc : public IoDevice{
+
+    private:
+        uint8_t adcsra;
+        uint8_t adcsrb;
+        uint8_t admux;
+        uint16_t result;
+        uint8_t latchedHigh;
+        bool latched; //ADCL was read and ADCH not yet
+        bool converting;
+        bool firstConversion;
+        uint64_t done;
+        std::array<uint16_t,ADC_CHANNELS> inputs;
+
+        uint64_t conversionCycles() const;
+        void start(uint64_t at);
+        void complete();
+
+    public:
+        Adc();
+        void reset() override;
+        void rebase(uint64_t now) override;
+        void attach(SRAM* sram);
+        uint8_t read(uint16_t addr) override;
+        void write(uint16_t addr, uint8_t val) override;
+        std::unique_ptr<IoDevice> save() const override;
+        void restore(const IoDevice& saved) override;
+        void sync(uint64_t now) override;
+        uint64_t nextDeadline() const override;
+
+        void setInput(uint8_t channel, uint16_t value);
+        bool interruptPending() const;
+};
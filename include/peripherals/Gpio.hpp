@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "IoDevice.hpp"
+#include "PinEventRing.hpp"
+
+class SRAM;
+
+static constexpr uint16_t PINB = 0x23;
+static constexpr uint16_t DDRB = 0x24;
+static constexpr uint16_t PORTB = 0x25;
+static constexpr uint16_t PINC = 0x26;
+static constexpr uint16_t DDRC = 0x27;
+static constexpr uint16_t PORTC = 0x28;
+static constexpr uint16_t PIND = 0x29;
+static constexpr uint16_t DDRD = 0x2A;
+static constexpr uint16_t PORTD = 0x2B;
+
+static constexpr size_t NUM_PORTS = 3; //B, C, D
+
+class Gpio : public IoDevice{
+
+    private:
+        struct Port {
+            uint8_t ddr;
+            uint8_t port;
+            uint8_t input;
+            uint8_t level;
+        };
+
+        std::array<Port,NUM_PORTS> ports;
+        PinEventRing* trace;
+
+        void update(uint8_t index);
+
+    public:
+        Gpio();
+        void reset() override;
+        uint8_t read(uint16_t addr) override;
+        void write(uint16_t addr, uint8_t val) override;
+        std::unique_ptr<IoDevice> save() const override;
+        void restore(const IoDevice& saved) override;
+
+        void setInput(uint8_t port, uint8_t value);
+        uint8_t getLevel(uint8_t port) const;
+        void setTrace(PinEventRing* trace);
+        void attach(SRAM* sram);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+//Peripheral mapped into the I/O part of the data space (0x20 - 0xFF)
+class IoDevice{
+
+    protected:
+        const uint64_t* clock = nullptr;
+
+        uint64_t now() const{
+            return clock ? *clock : 0;
+        }
+
+    public:
+        virtual ~IoDevice() = default;
+        virtual uint8_t read(uint16_t addr) = 0;
+        virtual void write(uint16_t addr, uint8_t val) = 0;
+
+        //Devices that keep their state lazily catch up here; nextDeadline is the
+        //first cycle at which they would raise something on their own
+        virtual void sync(uint64_t) {}
+        virtual uint64_t nextDeadline() const{
+            return UINT64_MAX;
+        }
+
+        //reset is the MCU reset; rebase is called when the CPU clock jumps (snapshot
+        //restore) so devices that remember a cycle carry on from the new one
+        //instead of waiting for the clock to get back to it
+        virtual void reset() {}
+        virtual void rebase(uint64_t) {}
+
+        //Snapshots: save returns a detached copy holding the device state (null
+        //for devices without any), restore copies such a state back in place
+        virtual std::unique_ptr<IoDevice> save() const{
+            return nullptr;
+        }
+        virtual void restore(const IoDevice&) {}
+
+        void setClock(const uint64_t* clock){
+            this->clock = clock;
+        }
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "IoDevice.hpp"
+
+class SRAM;
+
+struct TimerConfig {
+    bool wide; //Timer1 is 16-bit
+    uint16_t tccra;
+    uint16_t tccrb;
+    uint16_t tcnt;
+    uint16_t ocra;
+    uint16_t ocrb;
+    uint16_t icr;
+    uint16_t tifr;
+    uint16_t timsk;
+    std::array<uint16_t,8> prescalers; //Indexed by CSn2:0, 0 = no clock
+};
+
+static constexpr TimerConfig TIMER0 = {false, 0x44, 0x45, 0x46, 0x47, 0x48, 0x00, 0x35, 0x6E, {0, 1, 8, 64, 256, 1024, 0, 0}};
+static constexpr TimerConfig TIMER1 = {true, 0x80, 0x81, 0x84, 0x88, 0x8A, 0x86, 0x36, 0x6F, {0, 1, 8, 64, 256, 1024, 0, 0}};
+static constexpr TimerConfig TIMER2 = {false, 0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0x00, 0x37, 0x70, {0, 1, 8, 32, 64, 128, 256, 1024}};
+
+enum class TimerMode { Normal, CTC, Fast, PhaseCorrect };
+enum class TimerTop { Max, Fixed8, Fixed9, Fixed10, OCRA, ICR };
+
+static constexpr uint8_t TOV = 0x01;
+static constexpr uint8_t OCFA = 0x02;
+static constexpr uint8_t OCFB = 0x04;
+static constexpr uint8_t ICF = 0x20;
+
+//Timer/Counter that is never ticked. It remembers the cycle of its last sync and
+//works out TCNT and the flags from the elapsed cycles whenever the firmware
+//touches one of its registers or its next deadline is reached.
+class Timer : public IoDevice{
+
+    private:
+        TimerConfig config;
+        uint8_t tccra;
+        uint8_t tccrb;
+        uint16_t tcnt;
+        uint16_t ocra;
+        uint16_t ocrb;
+        uint16_t icr;
+        uint8_t tifr;
+        uint8_t timsk;
+        uint8_t temp; //Shared high byte for 16-bit accesses
+        bool down;
+        uint64_t lastSync;
+        uint64_t residual; //CPU cycles since the last timer tick
+
+        struct Event {
+            uint64_t position;
+            uint8_t flag;
+        };
+
+        uint8_t wgm() const;
+        TimerMode mode() const;
+        uint16_t top() const;
+        uint16_t max() const;
+        uint16_t prescaler() const;
+        uint64_t period() const;
+        uint64_t position() const;
+        size_t events(std::array<Event,6>& out) const;
+        uint64_t ticksUntil(uint64_t from, uint64_t event) const;
+        uint64_t ticksToMatch(uint16_t ocr) const;
+        void setPosition(uint64_t p);
+        void advance(uint64_t ticks);
+
+    public:
+        Timer(const TimerConfig& config);
+        void reset() override;
+        void rebase(uint64_t now) override;
+        void attach(SRAM* sram);
+        uint8_t read(uint16_t addr) override;
+        void write(uint16_t addr, uint8_t val) override;
+        std::unique_ptr<IoDevice> save() const override;
+        void restore(const IoDevice& saved) override;
+        void sync(uint64_t now) override;
+        uint64_t nextDeadline() const override;
+        bool interruptPending() const;
+        uint16_t getCount();
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "IoDevice.hpp"
+
+class SRAM;
+
+static constexpr uint16_t UCSR0A = 0xC0;
+static constexpr uint16_t UCSR0B = 0xC1;
+static constexpr uint16_t UCSR0C = 0xC2;
+static constexpr uint16_t UBRR0L = 0xC4;
+static constexpr uint16_t UBRR0H = 0xC5;
+static constexpr uint16_t UDR0 = 0xC6;
+
+static constexpr uint8_t RXC0 = 0x80;
+static constexpr uint8_t TXC0 = 0x40;
+static constexpr uint8_t UDRE0 = 0x20;
+
+//USART0 data path without baud timing: a byte written to UDR0 leaves at once
+//and a received byte waits in UDR0 until the firmware reads it. Where bytes
+//come from and go to is up to the owner (fuzz input, a Link, the host).
+class Usart : public IoDevice{
+
+    public:
+        using RxSource = std::function<bool(uint64_t now, uint8_t& byte)>;
+        using TxSink = std::function<void(uint64_t now, uint8_t byte)>;
+
+    private:
+        uint8_t ucsra;
+        uint8_t ucsrb;
+        uint8_t ucsrc;
+        uint8_t ubrrl;
+        uint8_t ubrrh;
+        uint8_t rxData;
+        bool rxFull;
+        bool txComplete;
+        RxSource rxSource;
+        TxSink txSink;
+
+        void poll();
+
+    public:
+        Usart();
+        void reset() override;
+        void attach(SRAM* sram);
+        uint8_t read(uint16_t addr) override;
+        void write(uint16_t addr, uint8_t val) override;
+        std::unique_ptr<IoDevice> save() const override;
+        void restore(const IoDevice& saved) override;
+
+        void setRxSource(const RxSource& source);
+        void setTxSink(const TxSink& sink);
+        bool rxPending() const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class InputKind : uint8_t {
+    UsartRx,
+    PinChange,
+    AdcSample,
+    Interrupt
+};
+
+struct InputEvent {
+    uint64_t cycle;
+    InputKind kind;
+    uint8_t channel; //Port, ADC channel, USART number or vector
+    uint16_t value;
+};
+
+//Compact log of everything nondeterministic that reached an instance. Cycles are
+//delta-encoded and all fields are varints, so a typical event takes 3-4 bytes.
+class InputLog{
+
+    private:
+        std::vector<uint8_t> bytes;
+        uint64_t lastCycle;
+        size_t events;
+
+        void putVarint(uint64_t value);
+
+    public:
+        class Reader{
+            private:
+                const InputLog* log;
+                size_t offset;
+                uint64_t cycle;
+                bool getVarint(uint64_t& value);
+            public:
+                Reader(const InputLog* log);
+                bool next(InputEvent& event);
+        };
+
+        InputLog();
+        void append(const InputEvent& event);
+        void clear();
+        size_t size() const;
+        size_t byteSize() const;
+        Reader reader() const;
+
+        void save(const std::string& path) const;
+        void load(const std::string& path);
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "cpu.hpp"
+#include "InputLog.hpp"
+#include "InputSinks.hpp"
+
+//Front door for host inputs: every input is stamped with the current cycle,
+//logged, then delivered. Cheap enough to leave on for every run.
+class InputRecorder{
+
+    private:
+        CPU* cpu;
+        InputSinks sinks;
+        InputLog* log;
+
+        void deliver(InputKind kind, uint8_t channel, uint16_t value);
+
+    public:
+        InputRecorder(CPU* cpu, const InputSinks& sinks, InputLog* log);
+        void usartRx(uint8_t usart, uint8_t byte);
+        void pinChange(uint8_t port, uint8_t value);
+        void adcSample(uint8_t channel, uint16_t value);
+        void interrupt(uint8_t vector);
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "cpu.hpp"
+#include "IoDevice.hpp"
+#include "InputLog.hpp"
+#include "InputSinks.hpp"
+
+//Feeds a recorded InputLog back through the device deadline mechanism: the next
+//event's cycle is the deadline, so delivery lands on the same instruction
+//boundary it was recorded on and the run loop pays nothing in between.
+class InputReplayer : public IoDevice{
+
+    private:
+        InputSinks sinks;
+        InputLog::Reader reader;
+        InputEvent pending;
+        bool hasPending;
+
+    public:
+        InputReplayer(const InputLog* log, const InputSinks& sinks);
+        uint8_t read(uint16_t addr) override;
+        void write(uint16_t addr, uint8_t val) override;
+        void sync(uint64_t now) override;
+        uint64_t nextDeadline() const override;
+        bool finished() const;
+
+        //Runs untraced up to traceFrom, then calls trace before every step
+        void run(CPU& cpu, uint64_t untilCycle, uint64_t traceFrom,
+                 const std::function<void(uint64_t cycle, uint16_t pc)>& trace);
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include "InputLog.hpp"
+#include "Gpio.hpp"
+#include "Adc.hpp"
+#include "Usart.hpp"
+
+//Bytes received on USART0, queued in arrival order and handed to the firmware
+//through the Usart's RxSource as it reads them
+class UsartInput{
+
+    private:
+        Usart* usart;
+        std::deque<uint8_t> pending;
+
+    public:
+        UsartInput();
+        ~UsartInput();
+        UsartInput(const UsartInput&) = delete;
+        UsartInput& operator=(const UsartInput&) = delete;
+
+        void attach(Usart* usart);
+        void push(uint8_t byte);
+        size_t size() const;
+};
+
+//Where each kind of input ends up. Interrupt injection goes through a host
+//callback until the interrupt controller is modelled.
+struct InputSinks {
+    Gpio* gpio = nullptr;
+    Adc* adc = nullptr;
+    UsartInput* usart = nullptr; //USART0 only
+    std::function<void(uint8_t vector)> interrupt;
+
+    void apply(const InputEvent& event) const;
+};
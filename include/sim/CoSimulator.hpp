@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "cpu.hpp"
+#include "Link.hpp"
+#include "Usart.hpp"
+
+static constexpr uint64_t MAX_INSTRUCTION_CYCLES = 4;
+
+//Runs several CPUs on their own threads. Every MCU advances one quantum and waits
+//for the others; links are flushed only while all of them are parked, so what a
+//firmware sees does not depend on thread scheduling. A link runs from the
+//sender's USART0 (bytes written to UDR0) to the receiver's (bytes read from
+//UDR0); each USART0 can feed one link and be fed by one.
+class CoSimulator{
+
+    private:
+        std::vector<CPU*> mcus;
+        std::vector<std::unique_ptr<Link>> links;
+        std::vector<std::unique_ptr<Usart>> usarts;
+        std::vector<bool> sending;
+        std::vector<bool> receiving;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t waiting;
+        uint64_t generation;
+        uint64_t horizon;
+        uint64_t end;
+        bool finished;
+        std::atomic<bool> failed;
+        std::exception_ptr error;
+
+        uint64_t quantum() const;
+        void worker(CPU* cpu);
+        bool barrier();
+
+    public:
+        CoSimulator();
+        size_t addMcu(CPU* cpu);
+        Link* connect(size_t from, size_t to, uint64_t latency);
+        Usart& getUsart(size_t mcu);
+        void run(uint64_t cycles);
+        uint64_t getQuantum() const;
+};
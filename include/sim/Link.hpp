@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct LinkByte {
+    uint64_t arrival;
+    uint8_t value;
+};
+
+//One-way wire between two MCUs. The sender only touches the outbox and the
+//receiver only touches the inbox, so both can run on their own threads between
+//two synchronization points.
+class Link{
+
+    private:
+        uint64_t latency;
+        std::vector<LinkByte> outbox;
+        std::deque<LinkByte> inbox;
+
+    public:
+        Link(uint64_t latency);
+        void send(uint64_t cycle, uint8_t value);
+        bool receive(uint64_t now, uint8_t& value);
+        void deliver();
+        uint64_t getLatency() const;
+
+        static uint64_t uartByteCycles(uint32_t baud, uint32_t clockHz, uint32_t frameBits = 10);
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct PinEvent {
+    uint64_t cycle;
+    uint8_t port;
+    uint8_t value;
+};
+
+static constexpr size_t RING_SIZE = 4096;
+
+//Single producer (the emulated MCU) / single consumer (the trace writer)
+class PinEventRing{
+
+    private:
+        std::array<PinEvent,RING_SIZE> events;
+        std::atomic<size_t> head;
+        std::atomic<size_t> tail;
+        std::atomic<uint64_t> drops;
+
+    public:
+        PinEventRing();
+        bool push(const PinEvent& event);
+        bool pop(PinEvent& event);
+        uint64_t getDrops() const;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "PinEventRing.hpp"
+#include "Gpio.hpp"
+
+//Drains a PinEventRing on a background thread and writes it out as a VCD file,
+//gzip-compressed when the path ends in ".gz". The dump starts from the pin
+//levels the Gpio has when the writer is created.
+class VcdWriter{
+
+    private:
+        PinEventRing* ring;
+        uint64_t psPerCycle;
+        std::FILE* file;
+        void* gz;
+        std::thread thread;
+        std::atomic<bool> running;
+        uint64_t lastCycle;
+        bool first;
+        uint64_t drops; //Ring drops already noted in the file
+
+        void emit(const std::string& text);
+        void writeHeader(const Gpio& pins);
+        void writeEvent(const PinEvent& event);
+        void noteDrops();
+        void loop();
+
+    public:
+        VcdWriter(PinEventRing* ring, const Gpio& pins, const std::string& path, uint32_t clockHz = 16000000);
+        ~VcdWriter();
+        void start();
+        void stop();
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+static constexpr uint64_t FNV1A_SEED = 0xcbf29ce484222325ULL;
+
+//64-bit FNV-1a; pass the previous result as `hash` to hash several buffers as one
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV1A_SEED){
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
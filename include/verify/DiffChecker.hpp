@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "cpu.hpp"
+
+struct SoakStats {
+    size_t programs;
+    uint64_t fewestRetired; //Shortest run, faults end a program early
+    uint64_t totalRetired;
+};
+
+struct Divergence {
+    uint64_t instruction; //Instructions retired before the divergent one
+    uint16_t pc;          //Address of the divergent instruction
+    std::string detail;
+};
+
+//Runs the reference stepper (plain decode, no fusion) and the optimized engine
+//(decode table + fused sequences) side by side on one Flash image. States are
+//compared by hash every `interval` instructions; on a mismatch both are rewound
+//to the last matching snapshot and the first divergent instruction is found
+//by bisection.
+class DiffChecker{
+
+    private:
+        struct Outcome {
+            uint64_t hash;
+            std::string error;
+        };
+
+        Flash* flash;
+        SRAM referenceSram;
+        SRAM optimizedSram;
+        CPU reference;
+        CPU optimized;
+        DecodeTable decodeTable;
+        FusionTable fusion;
+        uint64_t interval;
+        Divergence divergence;
+
+        static Outcome advance(CPU& cpu, uint64_t count);
+        void bisect(const CPU::Snapshot& referenceStart, const CPU::Snapshot& optimizedStart, uint64_t count);
+        static std::string describe(CPUState& a, CPUState& b);
+
+    public:
+        DiffChecker(Flash* flash, uint64_t interval = 1024);
+        void reset();
+        bool run(uint64_t instructions);
+        const Divergence& getDivergence() const;
+        CPU& getReference();
+        CPU& getOptimized();
+
+        static uint64_t hash(CPUState& state);
+        static bool soak(uint32_t seed, size_t programs, uint64_t instructions, Divergence& divergence, SoakStats& stats);
+};
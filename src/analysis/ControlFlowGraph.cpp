@@ -0,0 +1,319 @@
+#include "ControlFlowGraph.hpp"
+#include <algorithm>
+
+static constexpr uint16_t NOP = 0x0000;
+static constexpr uint16_t SLEEP = 0x9588;
+
+static uint16_t wrap(int32_t addr){
+    return static_cast<uint16_t>(addr & (WORDS - 1));
+}
+
+static bool isJmp(uint16_t op){
+    return (op & 0xFE0E) == 0x940C;
+}
+
+static bool isRjmp(uint16_t op){
+    return (op & 0xF000) == 0xC000;
+}
+
+//Classifies a control-flow instruction; anything else falls through
+static BlockExit exitOf(const uint16_t* words, uint16_t pc, size_t count, uint16_t& taken, uint16_t& next){
+    uint16_t op = words[pc];
+    taken = NO_TARGET;
+    next = NO_TARGET;
+    if(isRjmp(op)){
+        int16_t k = static_cast<int16_t>(op << 4) >> 4;
+        taken = wrap(pc + 1 + k);
+        return BlockExit::Jump;
+    }
+    if((op & 0xF000) == 0xD000){ //RCALL
+        int16_t k = static_cast<int16_t>(op << 4) >> 4;
+        taken = wrap(pc + 1 + k);
+        next = wrap(pc + 1);
+        return BlockExit::Call;
+    }
+    if(isJmp(op) || (op & 0xFE0E) == 0x940E){ //JMP, CALL (22-bit, only the low word matters here)
+        taken = pc + 1u < count ? wrap(words[pc + 1]) : NO_TARGET;
+        if(isJmp(op)){
+            return BlockExit::Jump;
+        }
+        next = wrap(pc + 2);
+        return BlockExit::Call;
+    }
+    if(op == 0x9509 || op == 0x9519){ //ICALL, EICALL
+        next = wrap(pc + 1);
+        return BlockExit::Call;
+    }
+    if(op == 0x9409 || op == 0x9419){ //IJMP, EIJMP
+        return BlockExit::Indirect;
+    }
+    if(op == 0x9508 || op == 0x9518){ //RET, RETI
+        return BlockExit::Return;
+    }
+    if((op & 0xF800) == 0xF000){ //BRBS, BRBC
+        int8_t k = static_cast<int8_t>((op >> 3) << 1) >> 1;
+        taken = wrap(pc + 1 + k);
+        next = wrap(pc + 1);
+        return BlockExit::Branch;
+    }
+    if((op & 0xFC00) == 0x1000 || (op & 0xFC08) == 0xFC00 || (op & 0xFD00) == 0x9900){ //CPSE, SBRC/SBRS, SBIC/SBIS
+        next = wrap(pc + 1);
+        taken = pc + 1u < count ? wrap(pc + 1 + ControlFlowGraph::length(words[pc + 1])) : NO_TARGET;
+        return BlockExit::Skip;
+    }
+    return BlockExit::FallThrough;
+}
+
+//Conservative: true whenever the instruction may write reg
+static bool writesRegister(uint16_t op, uint8_t reg){
+    uint8_t d = (op >> 4) & 0x1F;
+    uint8_t high = 16 + ((op >> 4) & 0x0F);
+    switch(op >> 12){
+        case 0x0:
+            if(op == NOP) return false;
+            if((op & 0xFF00) == 0x0100) return reg >> 1 == ((op >> 4) & 0x0F); //MOVW
+            if(op < 0x0400) return reg <= 1; //MULS, MULSU, FMUL*
+            if((op & 0xFC00) == 0x0400) return false; //CPC
+            return reg == d;
+        case 0x1:
+            if((op & 0xF800) == 0x1000) return false; //CPSE, CP
+            return reg == d;
+        case 0x2:
+            return reg == d;
+        case 0x3:
+            return false; //CPI
+        case 0x4: case 0x5: case 0x6: case 0x7: case 0xE:
+            return reg == high;
+        case 0x8: case 0xA:
+            return !(op & 0x0200) && reg == d; //LDD (STD does not write)
+        case 0x9:
+            if(op < 0x9200) return reg == d || reg >= 26; //LD/LPM/POP, pointer update
+            if(op < 0x9400) return reg >= 26; //ST/PUSH pointer update
+            if(op < 0x9600){
+                uint8_t low = op & 0x0F;
+                if(low <= 3 || low == 5 || low == 6 || low == 7 || low == 0xA) return reg == d;
+                return (op == 0x95C8 || op == 0x95D8) && reg == 0; //LPM, ELPM to r0
+            }
+            if(op < 0x9800) return (reg & ~1) == 24 + 2 * ((op >> 4) & 0x03); //ADIW, SBIW
+            if(op < 0x9C00) return false; //CBI, SBIC, SBI, SBIS
+            return reg <= 1; //MUL
+        case 0xB:
+            return !(op & 0x0800) && reg == d; //IN
+        case 0xF:
+            return (op & 0xFE00) == 0xF800 && reg == d; //BLD
+        default:
+            return false;
+    }
+}
+
+uint8_t ControlFlowGraph::length(uint16_t opcode){
+    //JMP, CALL, LDS, STS carry a second word
+    if((opcode & 0xFE0C) == 0x940C || (opcode & 0xFC0F) == 0x9000){
+        return 2;
+    }
+    return 1;
+}
+
+ControlFlowGraph::ControlFlowGraph(){
+    instructionCount = 0;
+}
+
+void ControlFlowGraph::clear(){
+    blocks.clear();
+    blockIndex.assign(WORDS, NO_TARGET);
+    starts.reset();
+    secondWords.reset();
+    callTargets.clear();
+    loops.clear();
+    instructionCount = 0;
+}
+
+void ControlFlowGraph::build(const uint16_t* words, size_t count){
+    clear();
+    count = std::min(count, WORDS);
+    if(count == 0){
+        return;
+    }
+
+    std::bitset<WORDS> leaders;
+    std::vector<uint16_t> work;
+    work.push_back(0);
+    //Only walk the interrupt vectors when word 0 looks like a vector table entry
+    if(isJmp(words[0]) || isRjmp(words[0])){
+        for(size_t v = 1; v < VECTORS && 2 * v < count; v++){
+            work.push_back(static_cast<uint16_t>(2 * v));
+        }
+    }
+    for(uint16_t entry : work){
+        leaders.set(entry);
+    }
+
+    //Pass 1: reachable instruction starts and block leaders
+    while(!work.empty()){
+        uint16_t pc = work.back();
+        work.pop_back();
+        while(pc < count && !starts[pc] && !secondWords[pc]){
+            uint8_t len = length(words[pc]);
+            starts.set(pc);
+            if(len == 2 && pc + 1u < count){
+                secondWords.set(pc + 1);
+            }
+            uint16_t taken, next;
+            BlockExit exit = exitOf(words, pc, count, taken, next);
+            if(exit != BlockExit::FallThrough){
+                for(uint16_t target : {taken, next}){
+                    if(target != NO_TARGET && target < count){
+                        leaders.set(target);
+                        work.push_back(target);
+                    }
+                }
+                if(exit == BlockExit::Call && taken != NO_TARGET){
+                    callTargets.push_back(taken);
+                }
+                break;
+            }
+            pc += len;
+        }
+    }
+
+    //Pass 2: cut the straight-line runs into blocks
+    size_t pc = 0;
+    while(pc < count){
+        if(!starts[pc]){
+            pc++;
+            continue;
+        }
+        BasicBlock block{static_cast<uint16_t>(pc), 0, NO_TARGET, NO_TARGET, 0, BlockExit::End, false};
+        bool idleBody = true;
+        while(true){
+            uint16_t op = words[pc];
+            block.instructions++;
+            block.exit = exitOf(words, static_cast<uint16_t>(pc), count, block.taken, block.next);
+            pc += length(op);
+            if(block.exit != BlockExit::FallThrough){
+                break;
+            }
+            idleBody = idleBody && (op == NOP || op == SLEEP);
+            if(pc >= count || !starts[pc]){
+                block.exit = BlockExit::End;
+                break;
+            }
+            if(leaders[pc]){
+                block.next = static_cast<uint16_t>(pc);
+                break;
+            }
+        }
+        block.end = static_cast<uint16_t>(std::min(pc, count));
+        block.idle = block.exit == BlockExit::Jump && block.taken == block.start && idleBody;
+        for(size_t w = block.start; w < block.end; w++){
+            blockIndex[w] = static_cast<uint16_t>(blocks.size());
+        }
+        blocks.push_back(block);
+    }
+
+    std::sort(callTargets.begin(), callTargets.end());
+    callTargets.erase(std::unique(callTargets.begin(), callTargets.end()), callTargets.end());
+    instructionCount = starts.count();
+    findLoops(words);
+}
+
+//Single-block loops closed by BRNE whose counter is loaded by LDI right before
+//the head and only touched by the decrement in front of the branch
+void ControlFlowGraph::findLoops(const uint16_t* words){
+    for(const BasicBlock& block : blocks){
+        if(block.exit != BlockExit::Branch || block.taken != block.start || block.instructions < 2){
+            continue;
+        }
+        uint16_t branch = block.start;
+        uint16_t counter = block.start;
+        for(uint16_t pc = block.start; pc < block.end; pc += length(words[pc])){
+            counter = branch;
+            branch = pc;
+        }
+        if((words[branch] & 0xFC07) != 0xF401){ //BRNE = BRBC Z
+            continue;
+        }
+
+        uint16_t op = words[counter];
+        uint8_t reg;
+        bool pair = false;
+        if((op & 0xFE0F) == 0x940A){ //DEC
+            reg = (op >> 4) & 0x1F;
+        }else if((op & 0xF000) == 0x5000 && (((op >> 4) & 0xF0) | (op & 0x0F)) == 1){ //SUBI 1
+            reg = 16 + ((op >> 4) & 0x0F);
+        }else if((op & 0xFF00) == 0x9700 && (((op & 0xC0) >> 2) | (op & 0x0F)) == 1){ //SBIW 1
+            reg = 24 + 2 * ((op >> 4) & 0x03);
+            pair = true;
+        }else{
+            continue;
+        }
+
+        bool clobbered = false;
+        for(uint16_t pc = block.start; pc < counter && !clobbered; pc += length(words[pc])){
+            clobbered = writesRegister(words[pc], reg) || (pair && writesRegister(words[pc], reg + 1));
+        }
+        if(clobbered || block.start == 0 || blockIndex[block.start - 1] == NO_TARGET){
+            continue;
+        }
+
+        //Last writers of the counter in the block falling into the head
+        const BasicBlock& before = blocks[blockIndex[block.start - 1]];
+        if(before.exit != BlockExit::FallThrough || before.next != block.start){
+            continue;
+        }
+        int32_t low = -1, high = pair ? -1 : 0;
+        for(uint16_t pc = before.start; pc < before.end; pc += length(words[pc])){
+            uint16_t w = words[pc];
+            bool ldi = (w & 0xF000) == 0xE000;
+            uint8_t value = ((w >> 4) & 0xF0) | (w & 0x0F);
+            if(writesRegister(w, reg)){
+                low = ldi && 16 + ((w >> 4) & 0x0F) == reg ? value : -1;
+            }
+            if(pair && writesRegister(w, reg + 1)){
+                high = ldi && 16 + ((w >> 4) & 0x0F) == reg + 1 ? value : -1;
+            }
+        }
+        if(low < 0 || high < 0){
+            continue;
+        }
+        uint32_t start = static_cast<uint32_t>(high << 8 | low);
+        uint32_t iterations = start ? start : (pair ? 0x10000 : 0x100);
+        loops.push_back({block.start, branch, reg, iterations});
+    }
+}
+
+bool ControlFlowGraph::isInstructionStart(uint16_t pc) const{
+    return pc < WORDS && starts[pc];
+}
+
+bool ControlFlowGraph::isSecondWord(uint16_t pc) const{
+    return pc < WORDS && secondWords[pc];
+}
+
+bool ControlFlowGraph::isIdleLoop(uint16_t pc) const{
+    const BasicBlock* block = blockAt(pc);
+    return block && block->idle;
+}
+
+const CountedLoop* ControlFlowGraph::loopAt(uint16_t head) const{
+    for(const CountedLoop& loop : loops){
+        if(loop.head == head) return &loop;
+    }
+    return nullptr;
+}
+
+size_t ControlFlowGraph::getInstructionCount() const{
+    return instructionCount;
+}
+
+const std::vector<BasicBlock>& ControlFlowGraph::getBlocks() const{
+    return blocks;
+}
+
+const std::vector<uint16_t>& ControlFlowGraph::getCallTargets() const{
+    return callTargets;
+}
+
+const std::vector<CountedLoop>& ControlFlowGraph::getLoops() const{
+    return loops;
+}
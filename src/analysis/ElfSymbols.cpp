@@ -0,0 +1,108 @@
+#include "ElfSymbols.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+static constexpr uint16_t EM_AVR = 83;
+static constexpr uint32_t SHT_SYMTAB = 2;
+static constexpr uint8_t STT_OBJECT = 1;
+static constexpr uint8_t STT_FUNC = 2;
+static constexpr uint32_t AVR_DATA_BASE = 0x800000; //avr-gcc puts the data space here
+
+template <typename T>
+static T get(const std::vector<uint8_t>& file, size_t offset){
+    if(offset + sizeof(T) > file.size()){
+        throw std::runtime_error("Truncated ELF file");
+    }
+    T value;
+    std::memcpy(&value, file.data() + offset, sizeof(T)); //ELF32 little endian, same as the host
+    return value;
+}
+
+void ElfSymbols::load(const std::string& path){
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if(file.size() < 52 || std::memcmp(file.data(), "\x7f" "ELF", 4) != 0 || file[4] != 1 || file[5] != 1){
+        throw std::runtime_error("Not a 32-bit little-endian ELF: " + path);
+    }
+    if(get<uint16_t>(file, 18) != EM_AVR){
+        throw std::runtime_error("Not an AVR ELF: " + path);
+    }
+
+    uint32_t shoff = get<uint32_t>(file, 32);
+    uint16_t shentsize = get<uint16_t>(file, 46);
+    uint16_t shnum = get<uint16_t>(file, 48);
+
+    functions.clear();
+    objects.clear();
+    for(uint16_t i = 0; i < shnum; i++){
+        size_t sh = shoff + static_cast<size_t>(i) * shentsize;
+        if(get<uint32_t>(file, sh + 4) != SHT_SYMTAB){
+            continue;
+        }
+        uint32_t symOffset = get<uint32_t>(file, sh + 16);
+        uint32_t symSize = get<uint32_t>(file, sh + 20);
+        uint32_t link = get<uint32_t>(file, sh + 24);
+        uint32_t entSize = get<uint32_t>(file, sh + 36);
+        size_t strSection = shoff + static_cast<size_t>(link) * shentsize;
+        uint32_t strOffset = get<uint32_t>(file, strSection + 16);
+        if(entSize == 0) continue;
+
+        for(uint32_t s = 0; s + entSize <= symSize; s += entSize){
+            size_t sym = symOffset + s;
+            uint32_t nameOffset = get<uint32_t>(file, sym);
+            uint32_t value = get<uint32_t>(file, sym + 4);
+            uint32_t size = get<uint32_t>(file, sym + 8);
+            uint8_t type = get<uint8_t>(file, sym + 12) & 0x0F;
+            size_t nameStart = strOffset + nameOffset;
+            if(nameStart >= file.size()) continue;
+            std::string name(reinterpret_cast<const char*>(file.data() + nameStart),
+                             strnlen(reinterpret_cast<const char*>(file.data() + nameStart), file.size() - nameStart));
+            if(name.empty()) continue;
+
+            if(type == STT_FUNC && value < AVR_DATA_BASE){
+                functions.push_back({name, value / 2, size, true});
+            }else if(value >= AVR_DATA_BASE){
+                objects.push_back({name, value - AVR_DATA_BASE, size, false});
+            }else if(type == STT_OBJECT){
+                objects.push_back({name, value / 2, size, false}); //Flash tables (PROGMEM)
+            }
+        }
+    }
+    std::sort(functions.begin(), functions.end(), [](const ElfSymbol& a, const ElfSymbol& b){
+        return a.address < b.address;
+    });
+}
+
+const ElfSymbol* ElfSymbols::functionAt(uint16_t pc) const{
+    auto it = std::upper_bound(functions.begin(), functions.end(), pc, [](uint16_t value, const ElfSymbol& s){
+        return value < s.address;
+    });
+    if(it == functions.begin()){
+        return nullptr;
+    }
+    --it;
+    if(it->size && pc >= it->address + (it->size + 1) / 2){
+        return nullptr;
+    }
+    return &*it;
+}
+
+const ElfSymbol* ElfSymbols::find(const std::string& name) const{
+    for(const ElfSymbol& s : functions){
+        if(s.name == name) return &s;
+    }
+    for(const ElfSymbol& s : objects){
+        if(s.name == name) return &s;
+    }
+    return nullptr;
+}
+
+const std::vector<ElfSymbol>& ElfSymbols::getFunctions() const{
+    return functions;
+}
@@ -0,0 +1,111 @@
+#include "MemoryStats.hpp"
+#include "CPUState.hpp"
+#include "ElfSymbols.hpp"
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+MemoryStats::MemoryStats(){
+    pc = nullptr;
+    clock = nullptr;
+    clear();
+}
+
+void MemoryStats::bind(const uint16_t* pc, const uint64_t* clock){
+    this->pc = pc;
+    this->clock = clock;
+}
+
+void MemoryStats::clear(){
+    reads.fill(0);
+    writes.fill(0);
+    written.reset();
+    firstWrites.clear();
+    spLow = RAMEND;
+    spLowPc = 0;
+    stackLows.clear();
+}
+
+void MemoryStats::firstWrite(uint16_t addr){
+    written.set(addr);
+    firstWrites.push_back({addr, clock ? *clock : 0});
+}
+
+void MemoryStats::newStackLow(uint16_t sp){
+    spLow = sp;
+    spLowPc = pc ? *pc : 0;
+    stackLows.push_back({spLowPc, sp});
+}
+
+uint16_t MemoryStats::getStackLow() const{
+    return spLow;
+}
+
+uint16_t MemoryStats::getPeakStackDepth() const{
+    return RAMEND - spLow;
+}
+
+uint64_t MemoryStats::getReads(size_t page) const{
+    return reads.at(page);
+}
+
+uint64_t MemoryStats::getWrites(size_t page) const{
+    return writes.at(page);
+}
+
+bool MemoryStats::wasWritten(uint16_t addr) const{
+    return addr < SIZE && written[addr];
+}
+
+const std::vector<FirstWrite>& MemoryStats::getFirstWrites() const{
+    return firstWrites;
+}
+
+const std::vector<StackLow>& MemoryStats::getStackLows() const{
+    return stackLows;
+}
+
+std::string MemoryStats::report(const ElfSymbols* symbols) const{
+    std::ostringstream out;
+    out << "stack low-water 0x" << std::hex << spLow << std::dec
+        << " (peak depth " << getPeakStackDepth() << " bytes, pc 0x" << std::hex << spLowPc << std::dec << ")\n";
+
+    if(symbols){
+        const ElfSymbol* heap = symbols->find("__heap_start");
+        if(!heap) heap = symbols->find("__bss_end");
+        if(heap && spLow <= heap->address){
+            out << "stack reached static data: low-water 0x" << std::hex << spLow
+                << " <= " << heap->name << " 0x" << heap->address << std::dec << "\n";
+        }
+    }
+
+    out << "page  reads  writes  touched\n";
+    for(size_t page = 0; page < PAGES; page++){
+        size_t touched = 0;
+        for(size_t addr = page * PAGE_BYTES; addr < std::min(SIZE, (page + 1) * PAGE_BYTES); addr++){
+            touched += written[addr];
+        }
+        out << "0x" << std::hex << page * PAGE_BYTES << std::dec << "  " << reads[page]
+            << "  " << writes[page] << "  " << touched << "\n";
+    }
+    out << "first writes: " << firstWrites.size() << " bytes\n";
+
+    //Each function's deepest point among the running low-water marks, i.e. the
+    //functions that pushed the stack to a new low and how far
+    if(symbols && !stackLows.empty()){
+        std::map<std::string,uint16_t> lowByFunction;
+        for(const StackLow& low : stackLows){
+            const ElfSymbol* function = symbols->functionAt(low.pc);
+            lowByFunction[function ? function->name : "?"] = low.sp; //Lows only decrease
+        }
+        std::vector<std::pair<std::string,uint16_t>> sorted(lowByFunction.begin(), lowByFunction.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b){
+            return a.second < b.second;
+        });
+        out << "stack low-water marks by function\n";
+        for(const auto& entry : sorted){
+            out << "  " << entry.first << "  " << RAMEND - entry.second << "\n";
+        }
+    }
+    return out.str();
+}
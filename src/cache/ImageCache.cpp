@@ -0,0 +1,185 @@
+#include "ImageCache.hpp"
+#include "Fnv1a.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef EMU_BUILD_ID
+#define EMU_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+static constexpr char CACHE_MAGIC[8] = {'A', 'V', 'R', 'C', 'A', 'C', 'H', 'E'};
+static constexpr uint32_t CACHE_VERSION = 1;
+static constexpr uint64_t CACHE_ALIGN = 64;
+
+static uint64_t alignUp(uint64_t value){
+    return (value + CACHE_ALIGN - 1) & ~(CACHE_ALIGN - 1);
+}
+
+ImageCache::ImageCache(const std::string& directory){
+    this->directory = directory;
+    mkdir(directory.c_str(), 0755);
+}
+
+ImageCache::~ImageCache(){
+    for(const auto& entry : mappings){
+        munmap(entry.second.addr, entry.second.size);
+    }
+}
+
+//The tables of `owner` now point into `mapping` (or at their own memory when it
+//is empty), so whatever they were mapped from before can go
+void ImageCache::adopt(const DecodeTable& owner, Mapping mapping){
+    auto it = mappings.find(&owner);
+    if(it != mappings.end()){
+        munmap(it->second.addr, it->second.size);
+        mappings.erase(it);
+    }
+    if(mapping.addr){
+        mappings[&owner] = mapping;
+    }
+}
+
+size_t ImageCache::mappedImages() const{
+    return mappings.size();
+}
+
+uint64_t ImageCache::imageHash(const Flash& flash){
+    uint64_t hash = FNV1A_SEED;
+    for(size_t addr = 0; addr < flash.size(); addr++){
+        uint16_t word = flash.read(addr);
+        hash = fnv1a(&word, sizeof(word), hash);
+    }
+    return hash;
+}
+
+//Cached files hold raw decoder-table indices and FusedOp bytes. EMU_BUILD_ID is
+//only taken at configure time, so the table layout, the FusedOp size and the
+//fusion format are hashed at run time too: an edited table gets a new id even
+//in a dirty tree.
+static uint64_t computeBuildId(){
+    uint64_t hash = fnv1a(EMU_BUILD_ID, sizeof(EMU_BUILD_ID) - 1);
+    InstructionDecoder decoder;
+    for(size_t i = 0; i < decoder.entries() && i < NOT_DECODED; i++){
+        uint16_t entry[2] = {0, 0};
+        uint8_t used = decoder.entryAt(static_cast<uint8_t>(i), entry[0], entry[1]) ? 1 : 0;
+        hash = fnv1a(&used, sizeof(used), hash);
+        hash = fnv1a(entry, sizeof(entry), hash);
+    }
+    uint64_t opSize = sizeof(FusedOp);
+    hash = fnv1a(&opSize, sizeof(opSize), hash);
+    return fnv1a(&FUSION_FORMAT, sizeof(FUSION_FORMAT), hash);
+}
+
+uint64_t ImageCache::buildId(){
+    static const uint64_t id = computeBuildId();
+    return id;
+}
+
+std::string ImageCache::pathFor(uint64_t imageHash) const{
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%016llx-%016llx.avrc",
+                  static_cast<unsigned long long>(imageHash), static_cast<unsigned long long>(buildId()));
+    return directory + name;
+}
+
+bool ImageCache::prepare(const Flash& flash, const InstructionDecoder& decoder, DecodeTable& decode, FusionTable& fusion){
+    uint64_t hash = imageHash(flash);
+    std::string path = pathFor(hash);
+    if(load(path, hash, decode, fusion)){
+        return true;
+    }
+    decode.build(flash, decoder);
+    fusion.build(flash);
+    adopt(decode, {nullptr, 0});
+    store(path, hash, decode, fusion);
+    return false;
+}
+
+bool ImageCache::load(const std::string& path, uint64_t imageHash, DecodeTable& decode, FusionTable& fusion){
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader)){
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED){
+        return false;
+    }
+
+    const uint8_t* base = static_cast<const uint8_t*>(addr);
+    CacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+        && header.version == CACHE_VERSION
+        && header.words == WORDS
+        && header.imageHash == imageHash
+        && header.buildId == buildId()
+        && header.totalSize == size
+        && header.fusionOpsCount > 0
+        && header.decodeOffset + WORDS <= size
+        && header.fusionIndexOffset + WORDS * sizeof(uint16_t) <= size
+        && header.fusionOpsOffset + header.fusionOpsCount * sizeof(FusedOp) <= size;
+    if(!valid){
+        munmap(addr, size);
+        return false;
+    }
+
+    decode.attach(base + header.decodeOffset);
+    fusion.attach(reinterpret_cast<const uint16_t*>(base + header.fusionIndexOffset),
+                  reinterpret_cast<const FusedOp*>(base + header.fusionOpsOffset),
+                  header.fusionOpsCount);
+    adopt(decode, {addr, size});
+    return true;
+}
+
+//Written to a unique temporary file and renamed so readers never see a partial
+//file, even with several threads or processes storing the same image
+void ImageCache::store(const std::string& path, uint64_t imageHash, const DecodeTable& decode, const FusionTable& fusion){
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.words = WORDS;
+    header.imageHash = imageHash;
+    header.buildId = buildId();
+    header.fusionOpsCount = fusion.count() + 1;
+    header.decodeOffset = alignUp(sizeof(CacheHeader));
+    header.fusionIndexOffset = alignUp(header.decodeOffset + WORDS);
+    header.fusionOpsOffset = alignUp(header.fusionIndexOffset + WORDS * sizeof(uint16_t));
+    header.totalSize = header.fusionOpsOffset + header.fusionOpsCount * sizeof(FusedOp);
+
+    std::vector<uint8_t> buffer(header.totalSize, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::memcpy(buffer.data() + header.decodeOffset, decode.data(), WORDS);
+    std::memcpy(buffer.data() + header.fusionIndexOffset, fusion.indexData(), WORDS * sizeof(uint16_t));
+    std::memcpy(buffer.data() + header.fusionOpsOffset, fusion.opsData(), header.fusionOpsCount * sizeof(FusedOp));
+
+    std::string tmp = path + ".XXXXXX";
+    int fd = mkstemp(&tmp[0]);
+    if(fd < 0){
+        return;
+    }
+    fchmod(fd, 0644);
+    std::FILE* file = fdopen(fd, "wb");
+    if(!file){
+        close(fd);
+        std::remove(tmp.c_str());
+        return;
+    }
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if(!ok || std::rename(tmp.c_str(), path.c_str()) != 0){
+        std::remove(tmp.c_str());
+    }
+}
@@ -0,0 +1,232 @@
+#include "avr_emu.h"
+#include "cpu.hpp"
+#include "ImageCache.hpp"
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+static_assert(AVR_NUM_REGS == RegisterFile::NUM_REGS, "Register count mismatch");
+static_assert(AVR_DATA_SIZE == SIZE, "Data space size mismatch");
+static_assert(AVR_FLASH_WORDS == WORDS, "Flash size mismatch");
+
+class HostIo : public IoDevice{
+
+    private:
+        avr_io_read_cb readCb;
+        avr_io_write_cb writeCb;
+        void* user;
+        bool* stop;
+
+    public:
+        HostIo(avr_io_read_cb readCb, avr_io_write_cb writeCb, void* user, bool* stop){
+            this->readCb = readCb;
+            this->writeCb = writeCb;
+            this->user = user;
+            this->stop = stop;
+        }
+
+        uint8_t read(uint16_t addr) override{
+            return readCb ? readCb(user, addr, now()) : 0;
+        }
+
+        void write(uint16_t addr, uint8_t val) override{
+            if(writeCb && writeCb(user, addr, val, now())){
+                *stop = true;
+            }
+        }
+};
+
+struct avr_emu {
+    Flash flash;
+    SRAM sram;
+    CPU cpu;
+    DecodeTable decode;
+    FusionTable fusion;
+    std::unique_ptr<ImageCache> cache; //Tables may point into its mappings
+    bool loaded;
+    std::vector<std::unique_ptr<HostIo>> io;
+    bool stop;
+    std::string error;
+
+    avr_emu() : cpu(&flash, &sram), loaded(false), stop(false){
+        cpu.setFusion(&fusion);
+        const char* dir = std::getenv("AVR_EMU_CACHE_DIR");
+        if(dir && *dir){
+            cache = std::make_unique<ImageCache>(dir);
+        }
+    }
+};
+
+//Decode table and fusion decisions for the current image, mapped from the
+//cache when one is set up
+static void prepareImage(avr_emu* emu){
+    if(emu->cache){
+        emu->cache->prepare(emu->flash, emu->cpu.getInstructionDecoder(), emu->decode, emu->fusion);
+    }else{
+        emu->decode.build(emu->flash, emu->cpu.getInstructionDecoder());
+        emu->fusion.build(emu->flash);
+    }
+    emu->cpu.setDecodeTable(&emu->decode);
+    emu->loaded = true;
+}
+
+//Temporary breakpoint that goes back to its old state however the run ends
+class BreakpointGuard{
+
+    private:
+        CPU& cpu;
+        uint16_t pc;
+        bool wasSet;
+
+    public:
+        BreakpointGuard(CPU& cpu, uint16_t pc) : cpu(cpu), pc(pc), wasSet(cpu.hasBreakpoint(pc)){
+            cpu.setBreakpoint(pc, true);
+        }
+        ~BreakpointGuard(){
+            cpu.setBreakpoint(pc, wasSet);
+        }
+        BreakpointGuard(const BreakpointGuard&) = delete;
+        BreakpointGuard& operator=(const BreakpointGuard&) = delete;
+};
+
+//Exceptions must not cross the C boundary
+template <typename F>
+static avr_status guarded(avr_emu* emu, F body){
+    try{
+        return body();
+    }catch(const std::out_of_range& e){
+        emu->error = e.what();
+        return AVR_MEMORY_FAULT;
+    }catch(const std::exception& e){
+        emu->error = e.what();
+        return AVR_ILLEGAL_OPCODE;
+    }
+}
+
+extern "C" {
+
+avr_emu* avr_create(void){
+    try{
+        return new avr_emu();
+    }catch(...){
+        return nullptr;
+    }
+}
+
+void avr_destroy(avr_emu* emu){
+    delete emu;
+}
+
+int avr_set_cache_dir(avr_emu* emu, const char* dir){
+    if(emu->loaded){
+        emu->error = "Cache directory must be set before loading Flash";
+        return -1;
+    }
+    try{
+        emu->cache = std::make_unique<ImageCache>(dir);
+        return 0;
+    }catch(const std::exception& e){
+        emu->error = e.what();
+        return -1;
+    }
+}
+
+int avr_load_flash(avr_emu* emu, const uint16_t* words, size_t count){
+    try{
+        emu->flash.load(std::vector<uint16_t>(words, words + count));
+        prepareImage(emu);
+        return 0;
+    }catch(const std::exception& e){
+        emu->error = e.what();
+        return -1;
+    }
+}
+
+int avr_flash_changed(avr_emu* emu){
+    try{
+        emu->flash.analyze();
+        prepareImage(emu);
+        return 0;
+    }catch(const std::exception& e){
+        emu->error = e.what();
+        return -1;
+    }
+}
+
+void avr_reset(avr_emu* emu){
+    emu->cpu.reset();
+}
+
+avr_status avr_run_cycles(avr_emu* emu, uint64_t cycles){
+    return guarded(emu, [emu, cycles](){
+        CPU& cpu = emu->cpu;
+        uint64_t end = cpu.getCycles() + cycles;
+        emu->stop = false;
+        while(cpu.getCycles() < end){
+            cpu.step(cpu);
+            if(emu->stop) return AVR_STOPPED;
+        }
+        return AVR_OK;
+    });
+}
+
+avr_status avr_run_until_pc(avr_emu* emu, uint16_t pc, uint64_t max_cycles){
+    return guarded(emu, [emu, pc, max_cycles](){
+        CPU& cpu = emu->cpu;
+        ProgramCounter& counter = cpu.getProgramCounter();
+        uint64_t end = cpu.getCycles() + max_cycles;
+        emu->stop = false;
+        //Keeps fused sequences from stepping over the target
+        BreakpointGuard guard(cpu, pc);
+        while(cpu.getCycles() < end){
+            cpu.step(cpu);
+            if(counter.get() == pc) return AVR_HIT_PC;
+            if(emu->stop) return AVR_STOPPED;
+        }
+        return AVR_OK;
+    });
+}
+
+uint64_t avr_cycles(avr_emu* emu){
+    return emu->cpu.getCycles();
+}
+
+const char* avr_last_error(avr_emu* emu){
+    return emu->error.c_str();
+}
+
+uint8_t* avr_regs(avr_emu* emu){
+    return emu->cpu.getRegisterFile().data();
+}
+
+uint8_t* avr_sreg(avr_emu* emu){
+    return emu->cpu.getStatusRegister().data();
+}
+
+uint16_t* avr_pc(avr_emu* emu){
+    return emu->cpu.getProgramCounter().data();
+}
+
+uint8_t* avr_data(avr_emu* emu){
+    return emu->sram.data();
+}
+
+uint16_t* avr_flash(avr_emu* emu){
+    return emu->flash.data();
+}
+
+int avr_set_io_callbacks(avr_emu* emu, uint16_t first, uint16_t last,
+                         avr_io_read_cb read, avr_io_write_cb write, void* user){
+    if(first < IO_START || last >= IO_END || first > last){
+        emu->error = "Not an I/O address range";
+        return -1;
+    }
+    emu->io.push_back(std::make_unique<HostIo>(read, write, user, &emu->stop));
+    for(uint32_t addr = first; addr <= last; addr++){
+        emu->sram.attach(static_cast<uint16_t>(addr), emu->io.back().get());
+    }
+    return 0;
+}
+
+}
@@ -51,6 +51,17 @@ uint8_t ALU::sub(uint8_t a, uint8_t b, bool carry, StatusRegister& sr) {
     return static_cast<uint8_t>(result);
 }
 
+//SBC/SBCI/CPC: borrows C and only keeps Z set, so a multi-byte result reads
+//as zero only if every byte of it is
+uint8_t ALU::subCarry(uint8_t a, uint8_t b, StatusRegister& sr) {
+
+    bool zero = sr.getFlag(FLAG_Z);
+    uint8_t result = sub(a, b, sr.getFlag(FLAG_C), sr);
+    sr.setFlag(FLAG_Z, zero && result == 0);
+
+    return result;
+}
+
 uint8_t ALU::and(uint8_t a, uint8_t b, StatusRegister& sr) {
 
     uint8_t result = a & b;
@@ -97,4 +108,43 @@ uint8_t ALU::xor(uint8_t a, uint8_t b, StatusRegister& sr) {
     sr.setFlag(FLAG_V, false);
 
     return result;
-}
\ No newline at end of file
+}
+
+//ADIW/SBIW: flags come from the whole 16-bit result
+uint16_t ALU::addWord(uint16_t a, uint8_t k, StatusRegister& sr) {
+
+    uint16_t result = a + k;
+
+    bool negative = (result & 0x8000) != 0;
+    bool overflow = !(a & 0x8000) && negative;
+    bool sign = negative ^ overflow;
+    bool zero = result == 0;
+    bool carryFlag = !negative && (a & 0x8000);
+
+    sr.setFlag(FLAG_N, negative);
+    sr.setFlag(FLAG_V, overflow);
+    sr.setFlag(FLAG_S, sign);
+    sr.setFlag(FLAG_Z, zero);
+    sr.setFlag(FLAG_C, carryFlag);
+
+    return result;
+}
+
+uint16_t ALU::subWord(uint16_t a, uint8_t k, StatusRegister& sr) {
+
+    uint16_t result = a - k;
+
+    bool negative = (result & 0x8000) != 0;
+    bool overflow = (a & 0x8000) && !negative;
+    bool sign = negative ^ overflow;
+    bool zero = result == 0;
+    bool carryFlag = negative && !(a & 0x8000);
+
+    sr.setFlag(FLAG_N, negative);
+    sr.setFlag(FLAG_V, overflow);
+    sr.setFlag(FLAG_S, sign);
+    sr.setFlag(FLAG_Z, zero);
+    sr.setFlag(FLAG_C, carryFlag);
+
+    return result;
+}
@@ -0,0 +1,24 @@
+#include "DecodeTable.hpp"
+
+DecodeTable::DecodeTable(){
+    entries.assign(WORDS, NOT_DECODED);
+    view = entries.data();
+}
+
+void DecodeTable::build(const Flash& flash, const InstructionDecoder& decoder){
+    entries.resize(WORDS);
+    for(size_t addr = 0; addr < WORDS; addr++){
+        entries[addr] = decoder.lookup(flash.read(addr));
+    }
+    view = entries.data();
+}
+
+void DecodeTable::attach(const uint8_t* entries){
+    this->entries.clear();
+    this->entries.shrink_to_fit();
+    view = entries;
+}
+
+const uint8_t* DecodeTable::data() const{
+    return view;
+}
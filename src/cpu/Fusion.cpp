@@ -0,0 +1,142 @@
+#include "Fusion.hpp"
+#include "cpu.hpp"
+#include "Coverage.hpp"
+
+static bool isLdi(uint16_t op){ return (op & 0xF000) == 0xE000; }
+static bool isSubi(uint16_t op){ return (op & 0xF000) == 0x5000; }
+static bool isSbci(uint16_t op){ return (op & 0xF000) == 0x4000; }
+static bool isCp(uint16_t op){ return (op & 0xFC00) == 0x1400; }
+static bool isCpc(uint16_t op){ return (op & 0xFC00) == 0x0400; }
+static bool isBranch(uint16_t op){ return (op & 0xF800) == 0xF000; } //BRBS/BRBC
+static bool isSbiw(uint16_t op){ return (op & 0xFF00) == 0x9700; }
+static bool isBrne(uint16_t op){ return (op & 0xFC07) == 0xF401; }
+
+static uint8_t immReg(uint16_t op){ return 16 + ((op >> 4) & 0x0F); }
+static uint8_t immVal(uint16_t op){ return ((op >> 4) & 0xF0) | (op & 0x0F); }
+static uint8_t regD(uint16_t op){ return (op >> 4) & 0x1F; }
+static uint8_t regR(uint16_t op){ return ((op >> 5) & 0x10) | (op & 0x0F); }
+static int8_t branchOffset(uint16_t op){ return static_cast<int8_t>((op >> 2) & 0xFE) >> 1; }
+
+FusionTable::FusionTable(){
+    clear();
+}
+
+void FusionTable::clear(){
+    index.assign(WORDS, 0);
+    ops.clear();
+    ops.push_back(FusedOp{}); //Slot 0 means "not fused"
+    indexView = index.data();
+    opsView = ops.data();
+    opsCount = ops.size();
+}
+
+//Uses tables that live elsewhere (a mapped cache file) instead of building them
+void FusionTable::attach(const uint16_t* index, const FusedOp* ops, size_t count){
+    this->index.clear();
+    this->ops.clear();
+    indexView = index;
+    opsView = ops;
+    opsCount = count;
+}
+
+FusedOp FusionTable::match(uint16_t first, uint16_t second, uint16_t third){
+    FusedOp op{};
+    if(isCp(first) && isCpc(second) && isBranch(third)){
+        op = {FusedKind::CpCpcBranch, 3, 4, regD(first), regR(first), regD(second), regR(second),
+              static_cast<uint8_t>(third & 0x07), (third & 0x0400) == 0, branchOffset(third)};
+    }else if(isSbiw(first) && isBrne(second)){
+        op = {FusedKind::SbiwBrne, 2, 4, static_cast<uint8_t>(24 + 2 * ((first >> 4) & 0x03)),
+              static_cast<uint8_t>(((first & 0xC0) >> 2) | (first & 0x0F)), 0, 0, 1, false, branchOffset(second)};
+    }else if(isLdi(first) && isLdi(second)){
+        op = {FusedKind::LdiPair, 2, 2, immReg(first), immVal(first), immReg(second), immVal(second), 0, false, 0};
+    }else if(isSubi(first) && isSbci(second)){
+        op = {FusedKind::SubiSbci, 2, 2, immReg(first), immVal(first), immReg(second), immVal(second), 0, false, 0};
+    }
+    return op;
+}
+
+void FusionTable::build(const Flash& flash){
+    clear();
+    for(size_t addr = 0; addr + 1 < WORDS; addr++){
+        uint16_t third = addr + 2 < WORDS ? flash.read(addr + 2) : 0xFFFF;
+        FusedOp op = match(flash.read(addr), flash.read(addr + 1), third);
+        if(op.kind != FusedKind::None){
+            index[addr] = static_cast<uint16_t>(ops.size());
+            ops.push_back(op);
+        }
+    }
+    indexView = index.data();
+    opsView = ops.data();
+    opsCount = ops.size();
+}
+
+const FusedOp* FusionTable::at(uint16_t addr) const{
+    if(addr >= WORDS || indexView[addr] == 0){
+        return nullptr;
+    }
+    return &opsView[indexView[addr]];
+}
+
+//Number of fused sequences, slot 0 excluded
+size_t FusionTable::count() const{
+    return opsCount - 1;
+}
+
+const uint16_t* FusionTable::indexData() const{
+    return indexView;
+}
+
+const FusedOp* FusionTable::opsData() const{
+    return opsView;
+}
+
+//Returns the cycles the covered instructions would have taken one by one
+uint8_t FusionTable::execute(const FusedOp& op, CPU& cpu) const{
+    RegisterFile& regs = cpu.getRegisterFile();
+    StatusRegister& sr = cpu.getStatusRegister();
+    ProgramCounter& pc = cpu.getProgramCounter();
+    ALU& alu = cpu.getAlu();
+    Coverage* coverage = cpu.getCoverage();
+
+    switch(op.kind){
+        case FusedKind::LdiPair:
+            regs.write(op.a, op.b);
+            regs.write(op.c, op.d);
+            pc.set(pc.get() + 2);
+            return 2;
+
+        case FusedKind::SubiSbci: {
+            regs.write(op.a, alu.sub(regs.read(op.a), op.b, false, sr));
+            regs.write(op.c, alu.subCarry(regs.read(op.c), op.d, sr));
+            pc.set(pc.get() + 2);
+            return 2;
+        }
+
+        case FusedKind::CpCpcBranch: {
+            alu.sub(regs.read(op.a), regs.read(op.b), false, sr);
+            alu.subCarry(regs.read(op.c), regs.read(op.d), sr);
+            uint16_t next = pc.get() + 3;
+            bool taken = sr.getFlag(1 << op.bit) == op.whenSet;
+            if(taken) next += op.offset;
+            pc.set(next);
+            if(coverage) coverage->edge(next);
+            return taken ? 4 : 3;
+        }
+
+        case FusedKind::SbiwBrne: {
+            uint16_t val = (regs.read(op.a + 1) << 8) | regs.read(op.a);
+            uint16_t result = alu.subWord(val, op.b, sr);
+            regs.write(op.a, result & 0xFF);
+            regs.write(op.a + 1, result >> 8);
+            uint16_t next = pc.get() + 2;
+            bool taken = !sr.getFlag(1 << op.bit);
+            if(taken) next += op.offset;
+            pc.set(next);
+            if(coverage) coverage->edge(next);
+            return taken ? 4 : 3;
+        }
+
+        default:
+            return 0;
+    }
+}
@@ -5,6 +5,7 @@
 #include "RegistersFile.hpp"
 #include <stdexcept>
 #include "cpu.hpp"
+#include "Coverage.hpp"
 
 constexpr uint8_t FLAG_I = 0x80;
 constexpr uint8_t FLAG_T = 0x40;
@@ -16,10 +17,40 @@ constexpr uint8_t FLAG_Z = 0x02;
 constexpr uint8_t FLAG_C = 0x01;
 
 
+//Decoders, defined below the table
+Instruction ADD(uint16_t opcode, CPU& cpu);
+Instruction ADC(uint16_t opcode, CPU& cpu);
+Instruction SUB(uint16_t opcode, CPU& cpu);
+Instruction SBC(uint16_t opcode, CPU& cpu);
+Instruction SUBI(uint16_t opcode, CPU& cpu);
+Instruction SBCI(uint16_t opcode, CPU& cpu);
+Instruction AND(uint16_t opcode, CPU& cpu);
+Instruction OR(uint16_t opcode, CPU& cpu);
+Instruction ANDI(uint16_t opcode, CPU& cpu);
+Instruction ORI(uint16_t opcode, CPU& cpu);
+Instruction EOR(uint16_t opcode, CPU& cpu);
+Instruction ADIW(uint16_t opcode, CPU& cpu);
+Instruction SBIW(uint16_t opcode, CPU& cpu);
+Instruction RJMP(uint16_t opcode, CPU& cpu);
+Instruction IJMP(uint16_t opcode, CPU& cpu);
+Instruction CP(uint16_t opcode, CPU& cpu);
+Instruction CPC(uint16_t opcode, CPU& cpu);
+Instruction BRBS(uint16_t opcode, CPU& cpu);
+Instruction BRBC(uint16_t opcode, CPU& cpu);
+Instruction LDI(uint16_t opcode, CPU& cpu);
+Instruction LD(uint16_t opcode, CPU& cpu);
+Instruction ST(uint16_t opcode, CPU& cpu);
+Instruction PUSH(uint16_t opcode, CPU& cpu);
+Instruction POP(uint16_t opcode, CPU& cpu);
+Instruction IN(uint16_t opcode, CPU& cpu);
+Instruction OUT(uint16_t opcode, CPU& cpu);
+Instruction MOV(uint16_t opcode, CPU& cpu);
+static bool pointerMode(uint16_t opcode, uint8_t& low, int8_t& step, uint8_t& q);
+
 struct InstructionPattern { 
     uint16_t mask;
     uint16_t pattern;
-    std::function<Instruction(uint16_t,CPU)> decoder;
+    std::function<Instruction(uint16_t,CPU&)> decoder;
 };
 
 
@@ -39,27 +70,82 @@ std::array<InstructionPattern, 131> instructionTable = {{
     {0xFF00, 0x9600, ADIW},
     {0XFF00, 0x9700, SBIW},
     {0xF000, 0xC000, RJMP},
-    {0xFFFF, 0x9609, IJMP},
+    {0xFFFF, 0x9409, IJMP},
+    {0xFC00, 0x1400, CP},
+    {0xFC00, 0x0400, CPC},
+    {0xFC00, 0xF000, BRBS},
+    {0xFC00, 0xF400, BRBC},
     {0xF000, 0xE000, LDI},
+    {0xFE0F, 0x900F, POP},
+    {0xFE0F, 0x920F, PUSH},
     {0xEE00, 0x8000, LD},
-    {0xFC00, 0x2C00, MOV}
+    {0xFC00, 0x2C00, MOV},
+    {0xEE00, 0x8200, ST},
+    {0xD200, 0x8000, LD}, //LDD Rd,Y+q / Z+q
+    {0xD200, 0x8200, ST}, //STD Y+q,Rr / Z+q,Rr
+    {0xF800, 0xB000, IN},
+    {0xF800, 0xB800, OUT}
 
 
 }};
 
-Instruction InstructionDecoder::decode(uint16_t opcode,CPU cpu) {
-    for (const auto& entry : instructionTable) {
-        if ((opcode & entry.mask) == entry.pattern) {
-            return entry.decoder(opcode,cpu);
+Instruction InstructionDecoder::decode(uint16_t opcode,CPU& cpu) {
+    return decodeIndexed(lookup(opcode), opcode, cpu);
+}
+
+//Index of the table entry that handles the opcode, NOT_DECODED if none does
+uint8_t InstructionDecoder::lookup(uint16_t opcode) const {
+    for (size_t i = 0; i < instructionTable.size(); i++) {
+        const auto& entry = instructionTable[i];
+        if (entry.decoder && (opcode & entry.mask) == entry.pattern) {
+            return static_cast<uint8_t>(i);
         }
     }
-    throw std::runtime_error("Opcode not supported");
+    return NOT_DECODED;
+}
+
+//False for words that reach an entry whose decoder still refuses them: the
+//reserved LD/ST pointer modes
+bool InstructionDecoder::accepts(uint16_t opcode) const {
+    uint8_t index = lookup(opcode);
+    if (index == NOT_DECODED) {
+        return false;
+    }
+    using Decoder = Instruction (*)(uint16_t, CPU&);
+    const Decoder* decoder = instructionTable[index].decoder.target<Decoder>();
+    if (decoder && (*decoder == LD || *decoder == ST)) {
+        uint8_t low, q;
+        int8_t step;
+        return pointerMode(opcode, low, step, q);
+    }
+    return true;
+}
+
+size_t InstructionDecoder::entries() const {
+    return instructionTable.size();
+}
+
+//Encoding of a table entry; false for unused slots
+bool InstructionDecoder::entryAt(uint8_t index, uint16_t& mask, uint16_t& pattern) const {
+    if (index >= instructionTable.size() || !instructionTable[index].decoder) {
+        return false;
+    }
+    mask = instructionTable[index].mask;
+    pattern = instructionTable[index].pattern;
+    return true;
+}
+
+Instruction InstructionDecoder::decodeIndexed(uint8_t index, uint16_t opcode, CPU& cpu) {
+    if (index >= instructionTable.size() || !instructionTable[index].decoder) {
+        throw std::runtime_error("Opcode not supported");
+    }
+    return instructionTable[index].decoder(opcode,cpu);
 }
 
 //INSTRUCTION SET
 //--------------------------------------------Arithmetic and Logic Instructions--------------------------------------------
 
-Instruction ADD(uint16_t opcode, CPU cpu) {
+Instruction ADD(uint16_t opcode, CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -80,7 +166,7 @@ Instruction ADD(uint16_t opcode, CPU cpu) {
     return inst;
 }
 
-Instruction ADC(uint16_t opcode,CPU cpu) {
+Instruction ADC(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -103,7 +189,7 @@ Instruction ADC(uint16_t opcode,CPU cpu) {
 }
 
 
-Instruction SUB(uint16_t opcode,CPU cpu) {
+Instruction SUB(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -123,7 +209,7 @@ Instruction SUB(uint16_t opcode,CPU cpu) {
     return inst;
 }
 
-Instruction SBC(uint16_t opcode,CPU cpu) {
+Instruction SBC(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -137,15 +223,14 @@ Instruction SBC(uint16_t opcode,CPU cpu) {
     inst.execute = [regs,rd,rr,alu, &sr, pc](){
         uint8_t val1 = regs->read(rd);
         uint8_t val2 = regs->read(rr);
-        bool carry = sr.getFlag(FLAG_C);
-        uint8_t result = alu->sub(val1, val2, carry, sr);
+        uint8_t result = alu->subCarry(val1, val2, sr);
         regs->write(rd, result);
         pc->increment();
     };  
     return inst;
 }
 
-Instruction SUBI(uint16_t opcode,CPU cpu) {
+Instruction SUBI(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -153,7 +238,7 @@ Instruction SUBI(uint16_t opcode,CPU cpu) {
     ProgramCounter* pc = &cpu.getProgramCounter();
 
     Instruction inst;
-    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t rd = inst.operands[0] = 16 + ((opcode >> 4) & 0x0F); //r16 - r31
     uint8_t K = inst.operands[1] = ((opcode & 0x0F00) >> 4) | (opcode & 0x000F);
 
     inst.execute = [regs,rd,K,alu, &sr, pc](){
@@ -165,7 +250,7 @@ Instruction SUBI(uint16_t opcode,CPU cpu) {
     return inst;
 }
 
-Instruction SBCI(uint16_t opcode,CPU cpu) {
+Instruction SBCI(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -173,13 +258,12 @@ Instruction SBCI(uint16_t opcode,CPU cpu) {
     ProgramCounter* pc = &cpu.getProgramCounter();
 
     Instruction inst;
-    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t rd = inst.operands[0] = 16 + ((opcode >> 4) & 0x0F); //r16 - r31
     uint8_t K = inst.operands[1] = ((opcode & 0x0F00) >> 4) | (opcode & 0x000F);
 
     inst.execute = [regs,rd,K,alu, &sr, pc](){
         uint8_t val1 = regs->read(rd);
-        bool carry = sr.getFlag(FLAG_C);
-        uint8_t result = alu->sub(val1, K, carry, sr);
+        uint8_t result = alu->subCarry(val1, K, sr);
         regs->write(rd, result);
         pc->increment();
     };  
@@ -187,7 +271,7 @@ Instruction SBCI(uint16_t opcode,CPU cpu) {
 }
 
 
-Instruction AND(uint16_t opcode,CPU cpu) {
+Instruction AND(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -209,7 +293,7 @@ Instruction AND(uint16_t opcode,CPU cpu) {
 }
 
 
-Instruction OR(uint16_t opcode,CPU cpu) {
+Instruction OR(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -230,7 +314,7 @@ Instruction OR(uint16_t opcode,CPU cpu) {
     return inst;
 }
 
-Instruction ANDI(uint16_t opcode,CPU cpu) {
+Instruction ANDI(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -238,7 +322,7 @@ Instruction ANDI(uint16_t opcode,CPU cpu) {
     ProgramCounter* pc = &cpu.getProgramCounter();
 
     Instruction inst;
-    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t rd = inst.operands[0] = 16 + ((opcode >> 4) & 0x0F); //r16 - r31
     uint8_t K = inst.operands[1] = ((opcode & 0x0F00) >> 4) | (opcode & 0x000F);  
 
     inst.execute = [regs,rd,K,alu, &sr, pc](){
@@ -250,14 +334,14 @@ Instruction ANDI(uint16_t opcode,CPU cpu) {
     return inst;
 }
 
-Instruction ORI(uint16_t opcode,CPU cpu) {
+Instruction ORI(uint16_t opcode,CPU& cpu) {
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
     StatusRegister& sr = cpu.getStatusRegister();
     ProgramCounter* pc = &cpu.getProgramCounter();
 
     Instruction inst;
-    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t rd = inst.operands[0] = 16 + ((opcode >> 4) & 0x0F); //r16 - r31
     uint8_t K = inst.operands[1] = ((opcode & 0x0F00) >> 4) | (opcode & 0x000F);
 
     inst.execute = [regs,rd,K,alu, &sr, pc](){
@@ -269,7 +353,7 @@ Instruction ORI(uint16_t opcode,CPU cpu) {
     return inst;
 }
 
-Instruction EOR(uint16_t opcode,CPU cpu) {
+Instruction EOR(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -290,7 +374,7 @@ Instruction EOR(uint16_t opcode,CPU cpu) {
     return inst;
 }
 
-Instruction ADIW(uint16_t opcode,CPU cpu) {
+Instruction ADIW(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -298,27 +382,22 @@ Instruction ADIW(uint16_t opcode,CPU cpu) {
     ProgramCounter* pc = &cpu.getProgramCounter();
 
     Instruction inst;
-    uint8_t rd = inst.operands[0] = ((opcode >> 4) & 0x03);
-    uint8_t K = inst.operands[1] = ((opcode & 0xC0) >> 4) | (opcode & 0x0F);
+    uint8_t rd = inst.operands[0] = 24 + 2 * ((opcode >> 4) & 0x03); //r24, r26, r28, r30
+    uint8_t K = inst.operands[1] = ((opcode & 0xC0) >> 2) | (opcode & 0x0F);
+    inst.cycles = 2;
 
     inst.execute = [regs,rd,K,alu, &sr, pc](){
-        //1st cycle
-        uint8_t rdLow = regs->read(rd);
-        uint8_t resultLow = alu->add(rdLow, K, false, sr);
-        regs->write(rd, resultLow);
-
-        //2nd cycle
-        uint8_t rdHigh = regs->read(rd + 1);
-        uint8_t resultHigh = alu->add(rdHigh, 0, sr.getFlag(FLAG_C), sr);
-        regs->write(rd + 1, resultHigh);
-
+        uint16_t val = (regs->read(rd + 1) << 8) | regs->read(rd);
+        uint16_t result = alu->addWord(val, K, sr);
+        regs->write(rd, result & 0xFF);
+        regs->write(rd + 1, result >> 8);
         pc->increment();
     };  
     return inst;
 }
 
 
-Instruction SBIW(uint16_t opcode,CPU cpu) {
+Instruction SBIW(uint16_t opcode,CPU& cpu) {
 
     RegisterFile* regs  = &cpu.getRegisterFile();
     ALU* alu  = &cpu.getAlu();
@@ -326,20 +405,15 @@ Instruction SBIW(uint16_t opcode,CPU cpu) {
     ProgramCounter* pc = &cpu.getProgramCounter();
 
     Instruction inst;
-    uint8_t rd = inst.operands[0] = ((opcode >> 4) & 0x03);
-    uint8_t K = inst.operands[1] = ((opcode & 0xC0) >> 4) | (opcode & 0x0F);
+    uint8_t rd = inst.operands[0] = 24 + 2 * ((opcode >> 4) & 0x03); //r24, r26, r28, r30
+    uint8_t K = inst.operands[1] = ((opcode & 0xC0) >> 2) | (opcode & 0x0F);
+    inst.cycles = 2;
 
     inst.execute = [regs,rd,K,alu, &sr, pc](){
-        //1st cycle
-        uint8_t rdLow = regs->read(rd);
-        uint8_t resultLow = alu->sub(rdLow, K, false, sr);
-        regs->write(rd, resultLow);
-
-        //2nd cycle
-        uint8_t rdHigh = regs->read(rd + 1);
-        uint8_t resultHigh = alu->sub(rdHigh, 0, sr.getFlag(FLAG_C), sr);
-        regs->write(rd + 1, resultHigh);
-
+        uint16_t val = (regs->read(rd + 1) << 8) | regs->read(rd);
+        uint16_t result = alu->subWord(val, K, sr);
+        regs->write(rd, result & 0xFF);
+        regs->write(rd + 1, result >> 8);
         pc->increment();
     };  
     return inst;
@@ -347,39 +421,116 @@ Instruction SBIW(uint16_t opcode,CPU cpu) {
 
 //--------------------------------------------Branch Instructions--------------------------------------------
 
-Instruction RJMP(uint16_t opcode, CPU cpu){
+Instruction RJMP(uint16_t opcode, CPU& cpu){
     Instruction inst;
     ProgramCounter* pc = &cpu.getProgramCounter();
-    uint16_t K = inst.operands[0] = opcode & 0x0FFF;
+    //12-bit offset; operands only has room for its low byte
+    uint16_t K = opcode & 0x0FFF;
+    inst.operands[0] = K & 0xFF;
     if (K & 0x0800) {
         K |= 0xF000;  
     }
+    inst.cycles = 2;
+    Coverage* coverage = cpu.getCoverage();
 
-    inst.execute = [pc,K](){
+    inst.execute = [pc,K,coverage](){
         uint16_t currentPc = pc->get();
         pc->set(currentPc + K + 1);
+        if(coverage) coverage->edge(pc->get());
     };
 
     return inst;
 }
 
-Instruction IJMP(uint16_t opcode, CPU cpu){
+Instruction IJMP(uint16_t, CPU& cpu){
     ProgramCounter* pc = &cpu.getProgramCounter();
     RegisterFile* regs = &cpu.getRegisterFile();
 
-    uint16_t Z = (regs->read(31) << 8) | regs->read(30);
-
     Instruction inst;
-    inst.execute = [pc,Z](){
+    inst.cycles = 2;
+    Coverage* coverage = cpu.getCoverage();
+
+    //Z is read when the jump executes, not when it is decoded
+    inst.execute = [pc,regs,coverage](){
+        uint16_t Z = (regs->read(31) << 8) | regs->read(30);
         pc->set(Z);
+        if(coverage) coverage->edge(Z);
     };
 
     return inst;
 }
 
+Instruction CP(uint16_t opcode, CPU& cpu){
+
+    RegisterFile* regs  = &cpu.getRegisterFile();
+    ALU* alu  = &cpu.getAlu();
+    StatusRegister& sr = cpu.getStatusRegister();
+    ProgramCounter* pc = &cpu.getProgramCounter();
+
+    Instruction inst;
+    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t rr = inst.operands[1] = ((opcode >> 5) & 0x10) | (opcode & 0x0F);
+
+    inst.execute = [regs,rd,rr,alu, &sr, pc](){
+        alu->sub(regs->read(rd), regs->read(rr), false, sr);
+        pc->increment();
+    };
+    return inst;
+}
+
+Instruction CPC(uint16_t opcode, CPU& cpu){
+
+    RegisterFile* regs  = &cpu.getRegisterFile();
+    ALU* alu  = &cpu.getAlu();
+    StatusRegister& sr = cpu.getStatusRegister();
+    ProgramCounter* pc = &cpu.getProgramCounter();
+
+    Instruction inst;
+    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t rr = inst.operands[1] = ((opcode >> 5) & 0x10) | (opcode & 0x0F);
+
+    inst.execute = [regs,rd,rr,alu, &sr, pc](){
+        alu->subCarry(regs->read(rd), regs->read(rr), sr);
+        pc->increment();
+    };
+    return inst;
+}
+
+//BRBS/BRBC cover BREQ, BRNE, BRCS, BRCC, BRLT, ... (bit s of SREG)
+Instruction branchIf(uint16_t opcode, CPU& cpu, bool whenSet){
+
+    StatusRegister& sr = cpu.getStatusRegister();
+    ProgramCounter* pc = &cpu.getProgramCounter();
+    Coverage* coverage = cpu.getCoverage();
+    CPU* owner = &cpu;
+
+    Instruction inst;
+    uint8_t s = inst.operands[0] = opcode & 0x07;
+    int8_t k = inst.operands[1] = static_cast<int8_t>((opcode >> 2) & 0xFE) >> 1;
+
+    inst.execute = [&sr,pc,s,k,whenSet,coverage,owner](){
+        uint16_t next = pc->get() + 1;
+        if(sr.getFlag(1 << s) == whenSet){
+            next += k;
+            owner->addCycles(1);
+        }
+        pc->set(next);
+        if(coverage) coverage->edge(next);
+    };
+    return inst;
+}
+
+Instruction BRBS(uint16_t opcode, CPU& cpu){
+    return branchIf(opcode, cpu, true);
+}
+
+Instruction BRBC(uint16_t opcode, CPU& cpu){
+    return branchIf(opcode, cpu, false);
+}
+
 //--------------------------------------------Data Transfer Instructions--------------------------------------------
 
-Instruction MOV(uint16_t opcode, CPU cpu){
+Instruction MOV(uint16_t opcode, CPU& cpu){
 
     ProgramCounter* pc = &cpu.getProgramCounter();
     RegisterFile* regs = &cpu.getRegisterFile();
@@ -398,114 +549,151 @@ Instruction MOV(uint16_t opcode, CPU cpu){
     return inst;
 }
 
-Instruction LDI(uint16_t opcode, CPU cpu){
+Instruction LDI(uint16_t opcode, CPU& cpu){
     ProgramCounter* pc = &cpu.getProgramCounter();
     RegisterFile* regs = &cpu.getRegisterFile();
     Instruction inst;
 
     uint8_t K = inst.operands[0] = ((opcode >> 4 )& 0xF0) | (opcode & 0x0F);
-    uint8_t rd = inst.operands[1] = 16 + (opcode & 0x00F0 >> 4);
+    uint8_t rd = inst.operands[1] = 16 + ((opcode >> 4) & 0x0F);
 
     inst.execute = [K,rd,pc,regs](){
         regs->write(rd,K);
         pc->increment();
     };
+    return inst;
 }
 
-Instruction LD(uint16_t opcode, CPU cpu){
+//LD/ST addressing: X, Y or Z, plain, post-increment, pre-decrement or with a
+//displacement (LDD/STD). Returns false for the other encodings in the range.
+static bool pointerMode(uint16_t opcode, uint8_t& low, int8_t& step, uint8_t& q){
+    step = 0;
+    q = 0;
+    if(!(opcode & 0x1000)){
+        //10q0 qqsd dddd yqqq: y selects Y over Z, q = 0 is plain LD/ST
+        low = (opcode & 0x0008) ? 28 : 30;
+        q = ((opcode >> 8) & 0x20) | ((opcode >> 7) & 0x18) | (opcode & 0x07);
+        return true;
+    }
+    switch(opcode & 0x000F){
+        case 0x000C: low = 26; return true;            // X
+        case 0x000D: low = 26; step = 1; return true;  // X+
+        case 0x000E: low = 26; step = -1; return true; // -X
+        case 0x0009: low = 28; step = 1; return true;  // Y+
+        case 0x000A: low = 28; step = -1; return true; // -Y
+        case 0x0001: low = 30; step = 1; return true;  // Z+
+        case 0x0002: low = 30; step = -1; return true; // -Z
+        default: return false;
+    }
+}
+
+static Instruction loadStore(uint16_t opcode, CPU& cpu, bool store){
     ProgramCounter* pc = &cpu.getProgramCounter();
     RegisterFile* regs = &cpu.getRegisterFile();
-    Instruction inst;
+    SRAM* sram = &cpu.getSRAM();
+
+    uint8_t low;
+    int8_t step;
+    uint8_t q;
+    if(!pointerMode(opcode, low, step, q)){
+        throw std::runtime_error("Opcode not supported");
+    }
 
-    uint8_t rd;
-    uint8_t N; //N represents the value of X,Y or Z 16-bit pointers
-
-    if(opcode & 0xFE00 == 0x9000){
-        switch (opcode & 0x000F){
-
-            case 0x000C: // LD Rd,X
-                LD_N(26,27,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x000D: // LD Rd,X+
-                LD_NPostInc(26,27,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x000E: // LD Rd,-X
-                LD_NPreDec(26,27,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x0009: // LD Rd,Y+
-                LD_NPostInc(28,29,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x000A: // LD Rd,-Y
-                LD_NPreDec(28,29,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x0001: // LD Rd,Z+
-                LD_NPostInc(30,31,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x0002: // LD Rd,-Z
-                LD_NPreDec(30,31,rd,inst,opcode,regs,pc,N);
-                break;
+    Instruction inst;
+    uint8_t r = inst.operands[0] = (opcode >> 4) & 0x1F;
+    inst.operands[1] = low;
+    inst.cycles = 2;
+
+    //Data goes through SRAM so I/O devices, register aliases and MemoryStats see it
+    inst.execute = [regs,sram,pc,r,low,step,q,store](){
+        uint16_t pointer = (regs->read(low + 1) << 8) | regs->read(low);
+        if(step < 0) pointer--;
+        uint16_t addr = pointer + q;
+        uint8_t val = store ? regs->read(r) : 0;
+        if(step > 0) pointer++;
+        if(step != 0){
+            regs->write(low, pointer & 0xFF);
+            regs->write(low + 1, pointer >> 8);
         }
-    }else if(opcode & 0xFE00 == 0x8000){
-        switch (opcode & 0x000F){
-            case 0x0008: // LD Rd,Y
-                LD_N(28,29,rd,inst,opcode,regs,pc,N);
-                break;
-            case 0x0000: // LD Rd,Z
-                LD_N(30,31,rd,inst,opcode,regs,pc,N);
-                break;
+        if(store){
+            sram->write(addr, val);
+        }else{
+            regs->write(r, sram->read(addr));
         }
-    }
+        pc->increment();
+    };
+    return inst;
+}
+
+Instruction LD(uint16_t opcode, CPU& cpu){
+    return loadStore(opcode, cpu, false);
 }
 
+Instruction ST(uint16_t opcode, CPU& cpu){
+    return loadStore(opcode, cpu, true);
+}
+
+Instruction PUSH(uint16_t opcode, CPU& cpu){
+    ProgramCounter* pc = &cpu.getProgramCounter();
+    RegisterFile* regs = &cpu.getRegisterFile();
+    SRAM* sram = &cpu.getSRAM();
 
-void LD_N(int lowByte, int highByte,uint16_t rd, Instruction inst,uint16_t opcode,RegisterFile* regs,ProgramCounter* pc,uint16_t N){
-    rd = inst.operands[0] = (opcode >> 4) & 0x001F;
-    uint16_t X = (regs->read(highByte) << 8) | regs->read(lowByte);
-    N = inst.operands[1] =  X;
+    Instruction inst;
+    uint8_t rr = inst.operands[0] = (opcode >> 4) & 0x1F;
+    inst.cycles = 2;
 
-    inst.execute = [regs,rd,N,pc](){
-        regs->write(rd,N);
+    inst.execute = [rr,pc,regs,sram](){
+        sram->push(regs->read(rr));
         pc->increment();
     };
+    return inst;
 }
 
-void LD_NPostInc(int lowByte, int highByte, uint16_t rd, Instruction inst,uint16_t opcode,RegisterFile* regs,ProgramCounter* pc,uint16_t N){
-    rd = inst.operands[0] = (opcode >> 4) & 0x001F;
-    uint16_t pointer = (regs->read(highByte) << 8) | regs->read(lowByte);
-    N = inst.operands[1] =  pointer;
-
-    inst.execute = [regs,rd,N,pc](){
-        //1st cycle
-        regs->write(rd,N);
+Instruction POP(uint16_t opcode, CPU& cpu){
+    ProgramCounter* pc = &cpu.getProgramCounter();
+    RegisterFile* regs = &cpu.getRegisterFile();
+    SRAM* sram = &cpu.getSRAM();
 
-        //2nd cycle
-        uint16_t postInc = N + 1;
-        regs->write(26,postInc & 0xFF);
-        regs->write(27,(postInc >> 8) & 0xFF);
+    Instruction inst;
+    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    inst.cycles = 2;
 
+    inst.execute = [rd,pc,regs,sram](){
+        regs->write(rd, sram->pop());
         pc->increment();
     };
-
+    return inst;
 }
 
-void LD_NPreDec(int lowByte, int highByte, uint16_t rd, Instruction inst,uint16_t opcode,RegisterFile* regs,ProgramCounter* pc,uint16_t N){
-    rd = inst.operands[0] = (opcode >> 4) & 0x001F;
-    uint16_t pointer = (regs->read(26) << 8) | regs->read(27);
-    N = inst.operands[1] =  pointer;
-
-    inst.execute = [regs,rd,N,pc](){
-        
-        //1st cycle
-        uint16_t preDec = N - 1;
-        regs->write(26,preDec & 0xFF);
-        regs->write(27,(preDec >> 8) & 0xFF);
-        uint16_t data = (regs->read(26) << 8) | regs->read(27);
+//I/O space A (0-63) is data address A + 0x20
+Instruction IN(uint16_t opcode, CPU& cpu){
+    ProgramCounter* pc = &cpu.getProgramCounter();
+    RegisterFile* regs = &cpu.getRegisterFile();
+    SRAM* sram = &cpu.getSRAM();
 
-        //2nd cycle
-        regs->write(rd,N);
+    Instruction inst;
+    uint8_t rd = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t A = inst.operands[1] = ((opcode >> 5) & 0x30) | (opcode & 0x0F);
 
+    inst.execute = [rd,A,pc,regs,sram](){
+        regs->write(rd, sram->read(IO_START + A));
         pc->increment();
     };
-
+    return inst;
 }
 
+Instruction OUT(uint16_t opcode, CPU& cpu){
+    ProgramCounter* pc = &cpu.getProgramCounter();
+    RegisterFile* regs = &cpu.getRegisterFile();
+    SRAM* sram = &cpu.getSRAM();
+
+    Instruction inst;
+    uint8_t rr = inst.operands[0] = (opcode >> 4) & 0x1F;
+    uint8_t A = inst.operands[1] = ((opcode >> 5) & 0x30) | (opcode & 0x0F);
+
+    inst.execute = [rr,A,pc,regs,sram](){
+        sram->write(IO_START + A, regs->read(rr));
+        pc->increment();
+    };
+    return inst;
+}
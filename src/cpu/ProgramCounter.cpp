@@ -22,6 +22,9 @@ void ProgramCounter::decrement() {
         pc--;
     }
 }
+uint16_t* ProgramCounter::data() {
+    return &pc;
+}
+
 ProgramCounter::ProgramCounter() : pc(0) {}
-ProgramCounter::ProgramCounter(uint16_t initialValue) : pc(initialValue) {}
-ProgramCounter::ProgramCounter(const ProgramCounter& other) : pc(other.pc) {}
\ No newline at end of file
+ProgramCounter::ProgramCounter(uint16_t initialValue) : pc(initialValue) {}
\ No newline at end of file
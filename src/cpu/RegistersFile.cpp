@@ -14,3 +14,7 @@ void RegisterFile::write(size_t index, uint8_t value) {
 void RegisterFile::clear() {
     regs.fill(0);
 }
+
+uint8_t* RegisterFile::data() {
+    return regs.data();
+}
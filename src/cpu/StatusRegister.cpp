@@ -20,3 +20,6 @@ void StatusRegister::set(uint8_t val) {
     flags = val;
 }
 
+uint8_t* StatusRegister::data() {
+    return &flags;
+}
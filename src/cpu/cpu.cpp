@@ -1,57 +1,235 @@
 #include "cpu.hpp"
+#include "MemoryStats.hpp"
+#include "ControlFlowGraph.hpp"
+#include "RuntimeMetrics.hpp"
 #include <iostream>
 
 CPU::CPU(Flash* flash,SRAM* sram){
-    this->flash = flash;
-    this->sram = sram;
+    cold.flash = flash;
+    cold.sram = sram;
+    cold.coverage = nullptr;
+    cold.fusion = nullptr;
+    cold.decodeTable = nullptr;
+    cold.instructionLimit = UINT64_MAX;
+    sram->bind(state.data.data(), state.regs.data(), state.sr.data(), &state.sp);
+    sram->setClock(&state.cycles);
     reset();
 }
 
 void CPU::reset() {
-    regs.clear();
-    sr.set(0);
-    pc.reset();
-    sram->getMem().fill(0);
+    state.regs.clear();
+    state.sr.set(0);
+    state.pc.reset();
+    state.sp = RAMEND;
+    state.cycles = 0;
+    state.instructions = 0;
+    state.data.fill(0);
+    cold.decodeLookups = 0;
+    cold.decodeHits = 0;
+    cold.sram->resetDevices();
 }
 
-void CPU::step(CPU cpu){
+void CPU::step(CPU& cpu){
+    //Fused sequence: one dispatch for the whole idiom
+    if(cold.fusion){
+        const FusedOp* op = cold.fusion->at(state.pc.get());
+        if(op && canFuse(*op)){
+            state.cycles += cold.fusion->execute(*op, *this);
+            state.instructions += op->length;
+            if(state.cycles >= cold.sram->getDeadline()){
+                cold.sram->syncDevices(state.cycles);
+            }
+            return;
+        }
+    }
     //Fetch
-    uint16_t opcode = cpu.flash->read(pc.get());
-    //Decode
-    Instruction instruction = instrcutionDecoder.decode(opcode,cpu);
+    uint16_t opcode = cold.flash->read(state.pc.get());
+    //Decode: from the table when it knows the word, by pattern search otherwise
+    uint8_t index = cold.decodeTable ? cold.decodeTable->at(state.pc.get()) : NOT_DECODED;
+    cold.decodeLookups++;
+    Instruction instruction;
+    if(index != NOT_DECODED){
+        cold.decodeHits++;
+        instruction = instrcutionDecoder.decodeIndexed(index, opcode, cpu);
+    }else{
+        instruction = instrcutionDecoder.decode(opcode,cpu);
+    }
     //Execute
     instruction.execute();
+    state.cycles += instruction.cycles;
+    state.instructions++;
+    //Peripherals are only brought up to date when one of them has something due
+    if(state.cycles >= cold.sram->getDeadline()){
+        cold.sram->syncDevices(state.cycles);
+    }
 }
 
-void CPU::run(CPU cpu){
-    int size = cpu.flash->size();
-    while(pc.get() < size){
+//Fall back to single steps when something has to be observed in the middle of
+//the sequence: a breakpoint on one of its later words, a peripheral deadline or
+//an instruction limit
+bool CPU::canFuse(const FusedOp& op){
+    if(state.cycles + op.maxCycles >= cold.sram->getDeadline()){
+        return false;
+    }
+    if(state.instructions + op.length > cold.instructionLimit){
+        return false;
+    }
+    if(!cold.breakpoints){
+        return true;
+    }
+    uint16_t addr = state.pc.get();
+    for(uint8_t i = 1; i < op.length; i++){
+        if(addr + i < WORDS && (*cold.breakpoints)[addr + i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+void CPU::run(CPU& cpu){
+    size_t size = cold.flash->size();
+    while(state.pc.get() < size){
         step(cpu);
     } 
 }
 
-ALU CPU::getAlu(){
+//Retires exactly `count` instructions (fewer if PC leaves Flash) and returns how many
+uint64_t CPU::runInstructions(CPU& cpu, uint64_t count){
+    uint64_t start = state.instructions;
+    size_t size = cold.flash->size();
+    cold.instructionLimit = start + count;
+    try{
+        while(state.instructions < cold.instructionLimit && state.pc.get() < size){
+            step(cpu);
+        }
+    }catch(...){
+        cold.instructionLimit = UINT64_MAX;
+        throw;
+    }
+    cold.instructionLimit = UINT64_MAX;
+    return state.instructions - start;
+}
+
+//Same loop in batches of METRICS_SAMPLE steps. Idle time is sampled once per
+//batch (the whole batch counts as idle if it ends in an idle loop) and the
+//counters only reach the shared slot every METRICS_FLUSH steps.
+void CPU::run(CPU& cpu, RunMetrics& metrics){
+    size_t size = cold.flash->size();
+    const ControlFlowGraph* cfg = cold.flash->getCfg();
+    uint32_t untilFlush = METRICS_FLUSH / METRICS_SAMPLE;
+    while(state.pc.get() < size){
+        uint64_t before = state.cycles;
+        for(uint32_t i = 0; i < METRICS_SAMPLE && state.pc.get() < size; i++){
+            step(cpu);
+        }
+        if(cfg && cfg->isIdleLoop(state.pc.get())){
+            metrics.idleCycles += state.cycles - before;
+        }
+        if(--untilFlush == 0){
+            metrics.flush(state.instructions, state.cycles, cold.decodeLookups, cold.decodeHits);
+            untilFlush = METRICS_FLUSH / METRICS_SAMPLE;
+        }
+    }
+    metrics.flush(state.instructions, state.cycles, cold.decodeLookups, cold.decodeHits);
+}
+
+ALU& CPU::getAlu(){
     return this->alu;
 }
 
-InstructionDecoder CPU::getInstructionDecoder(){
+InstructionDecoder& CPU::getInstructionDecoder(){
     return this->instrcutionDecoder;
 }
 
-RegisterFile CPU::getRegisterFile(){
-    return this->regs;
+RegisterFile& CPU::getRegisterFile(){
+    return state.regs;
+}
+
+ProgramCounter& CPU::getProgramCounter(){
+    return state.pc;
+}
+
+StatusRegister& CPU::getStatusRegister(){
+    return state.sr;
+}
+
+SRAM& CPU::getSRAM(){
+    return *cold.sram;
+}
+
+CPUState& CPU::getState(){
+    return state;
+}
+
+uint64_t CPU::getCycles(){
+    return state.cycles;
+}
+
+uint64_t CPU::getInstructions(){
+    return state.instructions;
 }
 
-ProgramCounter CPU::getProgramCounter(){
-    return this->pc;
+uint16_t CPU::getStackPointer(){
+    return state.sp;
 }
 
-StatusRegister CPU::getStatusRegister(){
-    return this->sr;
+Coverage* CPU::getCoverage(){
+    return cold.coverage;
 }
 
+void CPU::setCoverage(Coverage* coverage){
+    cold.coverage = coverage;
+}
+
+CPU::Snapshot CPU::snapshot(){
+    return state;
+}
+
+//Peripherals are not part of the snapshot; they are rebased onto its clock
+void CPU::restore(const Snapshot& snapshot){
+    state = snapshot;
+    cold.sram->rebaseDevices(state.cycles);
+}
+
+void CPU::addCycles(uint8_t extra){
+    state.cycles += extra;
+}
+
+FusionTable* CPU::getFusion(){
+    return cold.fusion;
+}
 
-int main(){
+void CPU::setFusion(FusionTable* fusion){
+    cold.fusion = fusion;
+}
+
+DecodeTable* CPU::getDecodeTable(){
+    return cold.decodeTable;
+}
+
+void CPU::setDecodeTable(DecodeTable* decodeTable){
+    cold.decodeTable = decodeTable;
+}
+
+void CPU::setBreakpoint(uint16_t addr, bool enabled){
+    if(addr >= WORDS){
+        throw std::out_of_range("Invalid address");
+    }
+    if(!cold.breakpoints){
+        if(!enabled) return;
+        cold.breakpoints = std::make_unique<std::bitset<WORDS>>();
+    }
+    (*cold.breakpoints)[addr] = enabled;
+}
+
+bool CPU::hasBreakpoint(uint16_t addr){
+    return cold.breakpoints && addr < WORDS && (*cold.breakpoints)[addr];
+}
 
-    return 0;
+//Stack and SRAM usage tracking; pass null to turn it off again
+void CPU::setMemoryStats(MemoryStats* stats){
+    if(stats){
+        stats->bind(state.pc.data(), &state.cycles);
+    }
+    cold.sram->setStats(stats);
 }
@@ -0,0 +1,53 @@
+#include "Coverage.hpp"
+#include <cstdlib>
+#include <sys/shm.h>
+
+Coverage::Coverage(){
+    localMap.fill(0);
+    map = localMap.data();
+    prevLoc = 0;
+    shared = nullptr;
+}
+
+Coverage::~Coverage(){
+    if(shared){
+        shmdt(shared);
+    }
+}
+
+bool Coverage::attachShared(){
+    const char* id = std::getenv("__AFL_SHM_ID");
+    if(!id){
+        return false;
+    }
+    void* addr = shmat(std::atoi(id), nullptr, 0);
+    if(addr == reinterpret_cast<void*>(-1)){
+        return false;
+    }
+    shared = addr;
+    map = static_cast<uint8_t*>(addr);
+    return true;
+}
+
+void Coverage::resetLocation(){
+    prevLoc = 0;
+}
+
+void Coverage::clear(){
+    for(size_t i = 0; i < MAP_SIZE; i++){
+        map[i] = 0;
+    }
+    prevLoc = 0;
+}
+
+size_t Coverage::countEdges() const{
+    size_t edges = 0;
+    for(size_t i = 0; i < MAP_SIZE; i++){
+        if(map[i]) edges++;
+    }
+    return edges;
+}
+
+uint8_t* Coverage::getMap(){
+    return map;
+}
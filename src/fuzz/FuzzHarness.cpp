@@ -0,0 +1,115 @@
+#include "FuzzHarness.hpp"
+#include <cstdlib>
+#include <stdexcept>
+
+FuzzHarness::FuzzHarness(CPU* cpu, Coverage* coverage, uint64_t watchdogCycles, uint64_t drainCycles){
+    this->cpu = cpu;
+    this->coverage = coverage;
+    this->watchdogCycles = watchdogCycles;
+    this->drainCycles = drainCycles;
+    this->executions = 0;
+    cpu->setCoverage(coverage);
+    usart.setRxSource([this](uint64_t, uint8_t& byte){
+        if(!rxAvailable()) return false;
+        byte = rxRead();
+        return true;
+    });
+    usart.attach(&cpu->getSRAM());
+    started = std::chrono::steady_clock::now();
+}
+
+//The CPU outlives the harness; its SRAM must not keep pointing at our USART
+FuzzHarness::~FuzzHarness(){
+    cpu->getSRAM().detach(&usart);
+    if(cpu->getCoverage() == coverage){
+        cpu->setCoverage(nullptr);
+    }
+}
+
+//Runs the firmware through its init code once, the resulting state is restored before every input
+void FuzzHarness::boot(uint64_t cycles){
+    cpu->reset();
+    Coverage* saved = cpu->getCoverage();
+    cpu->setCoverage(nullptr);
+    while(cpu->getCycles() < cycles){
+        cpu->step(*cpu);
+    }
+    cpu->setCoverage(saved);
+    snapshot = cpu->snapshot();
+    devices = cpu->getSRAM().saveDevices();
+}
+
+FuzzResult FuzzHarness::runOne(const uint8_t* data, size_t size){
+    //Timers, ADC, GPIO and the USART go back too, so an input runs alone the same way
+    cpu->restore(snapshot);
+    cpu->getSRAM().restoreDevices(devices);
+    coverage->resetLocation();
+    rxBuffer.assign(data, data + size);
+    executions++;
+
+    uint64_t start = cpu->getCycles();
+    uint64_t drainedAt = 0;
+    bool drained = false;
+    try{
+        while(true){
+            uint64_t now = cpu->getCycles();
+            //Input counts as consumed once the last byte has left UDR0 too
+            if(rxBuffer.empty() && !usart.rxPending()){
+                if(!drained){
+                    drained = true;
+                    drainedAt = now;
+                }
+                if(now - drainedAt >= drainCycles) return FuzzResult::Ok;
+            }
+            //Stopped consuming input, or still busy when the budget runs out
+            if(now - start >= watchdogCycles) return FuzzResult::Timeout;
+            cpu->step(*cpu);
+            uint16_t sp = cpu->getStackPointer();
+            if(sp < 0x0100 || sp > RAMEND) return FuzzResult::StackFault;
+        }
+    }catch(const std::out_of_range&){
+        return FuzzResult::MemoryFault;
+    }catch(const std::runtime_error&){
+        return FuzzResult::IllegalOpcode;
+    }catch(const std::exception&){
+        //e.g. std::bad_function_call from an instruction the decoder left empty
+        return FuzzResult::IllegalOpcode;
+    }
+}
+
+//Persistent loop: one process, one boot, many inputs
+uint64_t FuzzHarness::runPersistent(const std::function<bool(std::vector<uint8_t>&)>& nextInput, bool abortOnCrash){
+    std::vector<uint8_t> input;
+    uint64_t crashes = 0;
+    while(nextInput(input)){
+        FuzzResult result = runOne(input.data(), input.size());
+        if(result != FuzzResult::Ok){
+            crashes++;
+            if(abortOnCrash) std::abort();
+        }
+    }
+    return crashes;
+}
+
+bool FuzzHarness::rxAvailable() const{
+    return !rxBuffer.empty();
+}
+
+uint8_t FuzzHarness::rxRead(){
+    if(rxBuffer.empty()){
+        throw std::out_of_range("RX buffer empty");
+    }
+    uint8_t val = rxBuffer.front();
+    rxBuffer.pop_front();
+    return val;
+}
+
+uint64_t FuzzHarness::getExecutions() const{
+    return executions;
+}
+
+double FuzzHarness::execsPerSecond() const{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    if(elapsed.count() <= 0) return 0;
+    return executions / elapsed.count();
+}
@@ -0,0 +1,45 @@
+#include "OpcodeGenerator.hpp"
+#include <stdexcept>
+
+static constexpr int MAX_DRAWS = 64;
+
+OpcodeGenerator::OpcodeGenerator(const InstructionDecoder* decoder, uint32_t seed) : rng(seed){
+    this->decoder = decoder;
+    for(size_t i = 0; i < decoder->entries() && i < NOT_DECODED; i++){
+        uint16_t mask, pattern;
+        if(!decoder->entryAt(static_cast<uint8_t>(i), mask, pattern)){
+            continue;
+        }
+        //Skip entries that are completely shadowed by an earlier one
+        if(decoder->lookup(pattern) != i && mask == 0xFFFF){
+            continue;
+        }
+        indices.push_back(static_cast<uint8_t>(i));
+        masks.push_back(mask);
+        patterns.push_back(pattern);
+    }
+    if(indices.empty()){
+        throw std::runtime_error("Decoder table is empty");
+    }
+}
+
+uint16_t OpcodeGenerator::next(){
+    std::uniform_int_distribution<size_t> pick(0, indices.size() - 1);
+    while(true){
+        size_t entry = pick(rng);
+        for(int draw = 0; draw < MAX_DRAWS; draw++){
+            uint16_t opcode = (static_cast<uint16_t>(rng()) & ~masks[entry]) | patterns[entry];
+            if(decoder->lookup(opcode) == indices[entry] && decoder->accepts(opcode)){
+                return opcode;
+            }
+        }
+    }
+}
+
+std::vector<uint16_t> OpcodeGenerator::program(size_t words){
+    std::vector<uint16_t> program(words);
+    for(size_t i = 0; i < words; i++){
+        program[i] = i < PROLOGUE_WORDS ? PROLOGUE[i] : next();
+    }
+    return program;
+}
@@ -0,0 +1,83 @@
+#include "cpu.hpp"
+#include "Coverage.hpp"
+#include "FuzzHarness.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+//Fuzzing driver. The firmware is a raw little-endian Flash image; each input is
+//fed to USART0 after a common boot. With input files every one is run and
+//reported (corpus replay); without, one input is read from stdin and a crash
+//aborts the process, which is what afl-fuzz watches for.
+//Usage: ATMega328p-emulator firmware.bin [input...]
+
+static constexpr uint64_t BOOT_CYCLES = 16000;        //1 ms at 16 MHz
+static constexpr uint64_t WATCHDOG_CYCLES = 1600000;  //100 ms
+static constexpr uint64_t DRAIN_CYCLES = 16000;
+
+static const char* RESULT_NAMES[] = {"ok", "illegal opcode", "memory fault", "timeout", "stack fault"};
+
+static bool readFile(const char* path, std::vector<uint8_t>& bytes){
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::fprintf(stderr, "usage: %s firmware.bin [input...]\n", argv[0]);
+        return 2;
+    }
+    std::vector<uint8_t> image;
+    if(!readFile(argv[1], image)){
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 2;
+    }
+    std::vector<uint16_t> words((image.size() + 1) / 2, 0);
+    for(size_t i = 0; i < image.size(); i++){
+        words[i / 2] |= static_cast<uint16_t>(image[i]) << (8 * (i % 2));
+    }
+
+    Flash flash;
+    SRAM sram;
+    try{
+        flash.load(words);
+    }catch(const std::exception& e){
+        std::fprintf(stderr, "%s: %s\n", argv[1], e.what());
+        return 2;
+    }
+    CPU cpu(&flash, &sram);
+    Coverage coverage;
+    coverage.attachShared();
+    FuzzHarness harness(&cpu, &coverage, WATCHDOG_CYCLES, DRAIN_CYCLES);
+    harness.boot(BOOT_CYCLES);
+
+    if(argc == 2){
+        std::vector<uint8_t> input((std::istreambuf_iterator<char>(std::cin.rdbuf())), std::istreambuf_iterator<char>());
+        FuzzResult result = harness.runOne(input.data(), input.size());
+        if(result != FuzzResult::Ok){
+            std::abort();
+        }
+        return 0;
+    }
+
+    int crashes = 0;
+    for(int i = 2; i < argc; i++){
+        std::vector<uint8_t> input;
+        if(!readFile(argv[i], input)){
+            std::fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 2;
+        }
+        FuzzResult result = harness.runOne(input.data(), input.size());
+        std::printf("%s: %s\n", argv[i], RESULT_NAMES[static_cast<int>(result)]);
+        if(result != FuzzResult::Ok) crashes++;
+    }
+    std::printf("%d of %d inputs crashed, %zu edges\n", crashes, argc - 2, coverage.countEdges());
+    return crashes == 0 ? 0 : 1;
+}
@@ -1,7 +1,10 @@
 #include "Flash.hpp"
+#include "ControlFlowGraph.hpp"
+#include <algorithm>
 
 Flash::Flash(){
     mem.fill(0);
+    programWords = 0;
 }
 
 void Flash::load(const std::vector<uint16_t>& program){
@@ -11,6 +14,15 @@ void Flash::load(const std::vector<uint16_t>& program){
     for(size_t i =0;i<program.size(); i++){
         mem[i] = program[i];
     }
+    programWords = program.size();
+    analyze();
+}
+
+//Rebuilds the control-flow graph; needed after patching words through write/data
+void Flash::analyze(){
+    auto graph = std::make_shared<ControlFlowGraph>();
+    graph->build(mem.data(), programWords);
+    cfg = graph;
 }
 
 uint16_t Flash::read(uint16_t addr) const{
@@ -26,9 +38,18 @@ void Flash::write(uint16_t addr, uint16_t val){
         throw std::out_of_range("Invalid address");
     }
     mem[addr] = val;
-
+    programWords = std::max<size_t>(programWords, addr + 1);
+    cfg.reset(); //Stale until the next analyze
 }
 
 size_t Flash::size() const{
     return mem.size();
-}
\ No newline at end of file
+}
+
+uint16_t* Flash::data(){
+    return mem.data();
+}
+
+const ControlFlowGraph* Flash::getCfg() const{
+    return cfg.get();
+}
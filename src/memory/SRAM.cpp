@@ -1,17 +1,62 @@
 #include "SRAM.hpp"
+#include "MemoryStats.hpp"
+#include <algorithm>
+#include <cstring>
 
 SRAM::SRAM(){
-    mem.fill(0);
+    own.reset(new uint8_t[SIZE]());
+    mem = own.get();
+    regs = mem;
+    sreg = mem + SREG;
+    ownSp = 0;
+    sp = &ownSp;
+    io.fill(0);
+    clock = nullptr;
+    deadline = UINT64_MAX;
+    stats = nullptr;
+}
+
+//Moves the data space into the CPU state block and frees the private copy
+void SRAM::bind(uint8_t* data, uint8_t* regs, uint8_t* sreg, uint16_t* sp){
+    std::memcpy(data, mem, SIZE);
+    std::memcpy(regs, this->regs, IO_START);
+    *sreg = *this->sreg;
+    *sp = *this->sp;
+    mem = data;
+    this->regs = regs;
+    this->sreg = sreg;
+    this->sp = sp;
+    own.reset();
 }
 
 std::array<uint8_t,SIZE> SRAM::getMem(){
-    return this->mem;
+    std::array<uint8_t,SIZE> copy;
+    std::memcpy(copy.data(), mem, SIZE);
+    return copy;
+}
+
+uint8_t* SRAM::data(){
+    return mem;
 }
 
 uint8_t SRAM::read(uint16_t addr) const{
     if(addr >= SIZE){
         throw std::out_of_range("Invalid address");
     }
+    if(stats){
+        stats->onRead(addr);
+    }
+    if(addr < IO_START){
+        return regs[addr];
+    }
+    if(addr < IO_END){
+        if(io[addr - IO_START]){
+            return devices[io[addr - IO_START] - 1]->read(addr);
+        }
+        if(addr == SPL) return *sp & 0xFF;
+        if(addr == SPH) return *sp >> 8;
+        if(addr == SREG) return *sreg;
+    }
     return mem[addr];
 }
 
@@ -19,9 +64,49 @@ void SRAM::write(uint16_t addr, uint8_t val){
     if(addr >= SIZE){
         throw std::out_of_range("Invalid address");
     }
+    if(stats){
+        stats->onWrite(addr);
+    }
+    if(addr < IO_START){
+        regs[addr] = val;
+        return;
+    }
+    if(addr < IO_END){
+        if(io[addr - IO_START]){
+            devices[io[addr - IO_START] - 1]->write(addr, val);
+            updateDeadline();
+            return;
+        }
+        if(addr == SPL){
+            *sp = (*sp & 0xFF00) | val;
+            //avr-gcc writes SPH first, so SPL completes the new stack pointer
+            if(stats) stats->onStackPointer(*sp);
+            return;
+        }
+        if(addr == SPH){
+            *sp = (*sp & 0x00FF) | (val << 8);
+            return;
+        }
+        if(addr == SREG){
+            *sreg = val;
+            return;
+        }
+    }
     mem[addr] = val;
 }
 
+//Post-decrement push, pre-increment pop
+void SRAM::push(uint8_t val){
+    write(*sp, val);
+    (*sp)--;
+    if(stats) stats->onStackPointer(*sp);
+}
+
+uint8_t SRAM::pop(){
+    (*sp)++;
+    return read(*sp);
+}
+
 uint8_t SRAM::readSRAM(uint16_t addr) const{
     if(addr < 0x0100 || addr > 0x08FF){
         throw std::out_of_range("Invalid address");
@@ -29,12 +114,102 @@ uint8_t SRAM::readSRAM(uint16_t addr) const{
     return mem[addr]; 
 }
 
-RegisterFile& SRAM::getRegs(){
-    return this->regs;
+void SRAM::attach(uint16_t addr, IoDevice* device){
+    if(addr < IO_START || addr >= IO_END){
+        throw std::out_of_range("Not an I/O address");
+    }
+    addDevice(device);
+    auto it = std::find(devices.begin(), devices.end(), device);
+    io[addr - IO_START] = static_cast<uint8_t>(it - devices.begin() + 1);
+}
+
+//Devices without registers (e.g. an input replayer) still get synced on their deadlines
+void SRAM::addDevice(IoDevice* device){
+    device->setClock(clock);
+    if(std::find(devices.begin(), devices.end(), device) == devices.end()){
+        if(devices.size() >= 0xFF){
+            throw std::length_error("Too many I/O devices");
+        }
+        devices.push_back(device);
+    }
+    updateDeadline();
+}
+
+//Unmaps every register of the device and forgets it
+void SRAM::detach(IoDevice* device){
+    auto it = std::find(devices.begin(), devices.end(), device);
+    if(it == devices.end()){
+        return;
+    }
+    uint8_t index = static_cast<uint8_t>(it - devices.begin() + 1);
+    devices.erase(it);
+    for(uint8_t& slot : io){
+        if(slot == index){
+            slot = 0;
+        }else if(slot > index){
+            slot--;
+        }
+    }
+    updateDeadline();
+}
+
+void SRAM::setClock(const uint64_t* clock){
+    this->clock = clock;
+    for(IoDevice* device : devices){
+        device->setClock(clock);
+    }
 }
 
-StatusRegister& SRAM::getStatusRegister(){
-    return this->sr;
+void SRAM::setStats(MemoryStats* stats){
+    this->stats = stats;
 }
 
+void SRAM::syncDevices(uint64_t now){
+    for(IoDevice* device : devices){
+        device->sync(now);
+    }
+    updateDeadline();
+}
 
+void SRAM::resetDevices(){
+    for(IoDevice* device : devices){
+        device->reset();
+    }
+    updateDeadline();
+}
+
+//The clock was moved under the devices; deadlines computed from the old one are void
+void SRAM::rebaseDevices(uint64_t now){
+    for(IoDevice* device : devices){
+        device->rebase(now);
+    }
+    updateDeadline();
+}
+
+//Device half of a snapshot, one entry per device in attach order
+std::vector<std::unique_ptr<IoDevice>> SRAM::saveDevices() const{
+    std::vector<std::unique_ptr<IoDevice>> saved;
+    for(IoDevice* device : devices){
+        saved.push_back(device->save());
+    }
+    return saved;
+}
+
+void SRAM::restoreDevices(const std::vector<std::unique_ptr<IoDevice>>& saved){
+    if(saved.size() != devices.size()){
+        throw std::invalid_argument("Device snapshot does not match the attached devices");
+    }
+    for(size_t i = 0; i < devices.size(); i++){
+        if(saved[i]){
+            devices[i]->restore(*saved[i]);
+        }
+    }
+    updateDeadline();
+}
+
+void SRAM::updateDeadline(){
+    deadline = UINT64_MAX;
+    for(IoDevice* device : devices){
+        deadline = std::min(deadline, device->nextDeadline());
+    }
+}
@@ -0,0 +1,125 @@
+#include "RuntimeMetrics.hpp"
+#include "PinEventRing.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+void RunMetrics::flush(uint64_t instructions, uint64_t cycles, uint64_t decodeLookups, uint64_t decodeHits){
+    if(!slot){
+        return;
+    }
+    uint64_t pending = 0;
+    for(const auto& source : interruptSources){
+        pending += source() ? 1 : 0;
+    }
+    slot->instructions.store(instructions, std::memory_order_relaxed);
+    slot->cycles.store(cycles, std::memory_order_relaxed);
+    slot->idleCycles.store(idleCycles, std::memory_order_relaxed);
+    slot->decodeHits.store(decodeHits, std::memory_order_relaxed);
+    slot->decodeLookups.store(decodeLookups, std::memory_order_relaxed);
+    slot->pendingInterrupts.store(pending, std::memory_order_relaxed);
+    slot->traceDrops.store(trace ? trace->getDrops() : 0, std::memory_order_relaxed);
+}
+
+MetricsRegistry::MetricsRegistry(){
+    interval = std::chrono::milliseconds(1000);
+    lastRender = std::chrono::steady_clock::now();
+    running = false;
+}
+
+MetricsRegistry::~MetricsRegistry(){
+    stop();
+}
+
+//Slots are heap-allocated one by one so adding an instance never moves a live slot
+MetricsSlot* MetricsRegistry::add(const std::string& name){
+    std::lock_guard<std::mutex> guard(lock);
+    entries.push_back({name, std::make_unique<MetricsSlot>(), 0});
+    return entries.back().slot.get();
+}
+
+std::string MetricsRegistry::render(){
+    std::lock_guard<std::mutex> guard(lock);
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastRender).count();
+    lastRender = now;
+
+    std::ostringstream out;
+    out << "# TYPE avr_instructions_total counter\n"
+        << "# TYPE avr_cycles_total counter\n"
+        << "# TYPE avr_idle_cycles_total counter\n"
+        << "# TYPE avr_decode_hits_total counter\n"
+        << "# TYPE avr_decode_lookups_total counter\n"
+        << "# TYPE avr_trace_drops_total counter\n"
+        << "# TYPE avr_pending_interrupts gauge\n"
+        << "# TYPE avr_mips gauge\n";
+    for(Entry& entry : entries){
+        const MetricsSlot& slot = *entry.slot;
+        std::string label = "{instance=\"" + entry.name + "\"} ";
+        uint64_t instructions = slot.instructions.load(std::memory_order_relaxed);
+        double mips = seconds > 0 ? (instructions - entry.lastInstructions) / seconds / 1e6 : 0;
+        entry.lastInstructions = instructions;
+
+        out << "avr_instructions_total" << label << instructions << "\n"
+            << "avr_cycles_total" << label << slot.cycles.load(std::memory_order_relaxed) << "\n"
+            << "avr_idle_cycles_total" << label << slot.idleCycles.load(std::memory_order_relaxed) << "\n"
+            << "avr_decode_hits_total" << label << slot.decodeHits.load(std::memory_order_relaxed) << "\n"
+            << "avr_decode_lookups_total" << label << slot.decodeLookups.load(std::memory_order_relaxed) << "\n"
+            << "avr_trace_drops_total" << label << slot.traceDrops.load(std::memory_order_relaxed) << "\n"
+            << "avr_pending_interrupts" << label << slot.pendingInterrupts.load(std::memory_order_relaxed) << "\n"
+            << "avr_mips" << label << mips << "\n";
+    }
+    return out.str();
+}
+
+void MetricsRegistry::publish(){
+    std::string text = render();
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    std::FILE* file = std::fopen(tmp.c_str(), "w");
+    if(!file){
+        throw std::runtime_error("Cannot open " + tmp);
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = std::fclose(file) == 0 && ok;
+    if(!ok || std::rename(tmp.c_str(), path.c_str()) != 0){
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void MetricsRegistry::loop(){
+    auto next = std::chrono::steady_clock::now() + interval;
+    while(running.load(std::memory_order_relaxed)){
+        //Short sleeps keep stop() responsive with long intervals
+        std::this_thread::sleep_for(std::min(interval, std::chrono::milliseconds(50)));
+        if(std::chrono::steady_clock::now() >= next){
+            tryPublish();
+            next += interval;
+        }
+    }
+    tryPublish();
+}
+
+//A full disk must not take the run down with it; the scraper just sees a stale file
+void MetricsRegistry::tryPublish(){
+    try{
+        publish();
+    }catch(const std::runtime_error&){
+    }
+}
+
+void MetricsRegistry::start(const std::string& path, std::chrono::milliseconds interval){
+    if(running) return;
+    this->path = path;
+    this->interval = interval;
+    running = true;
+    thread = std::thread(&MetricsRegistry::loop, this);
+}
+
+void MetricsRegistry::stop(){
+    if(!running) return;
+    running = false;
+    thread.join();
+}
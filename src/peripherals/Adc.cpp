@@ -0,0 +1,153 @@
+#include "Adc.hpp"
+#include "SRAM.hpp"
+#include <stdexcept>
+
+static constexpr uint16_t ADC_DIVIDERS[8] = {2, 2, 4, 8, 16, 32, 64, 128};
+
+Adc::Adc(){
+    inputs.fill(0);
+    inputs[14] = 225; //1.1V bandgap against a 5V reference
+    reset();
+}
+
+//Analog inputs are outside the MCU and survive a reset
+
+void Adc::reset(){
+    adcsra = 0;
+    adcsrb = 0;
+    admux = 0;
+    result = 0;
+    latchedHigh = 0;
+    latched = false;
+    converting = false;
+    firstConversion = true;
+    done = 0;
+}
+
+//A conversion in flight restarts from the new clock
+void Adc::rebase(uint64_t now){
+    if(converting){
+        done = now + conversionCycles();
+    }
+}
+
+void Adc::attach(SRAM* sram){
+    sram->attach(ADCL, this);
+    sram->attach(ADCH, this);
+    sram->attach(ADCSRA, this);
+    sram->attach(ADCSRB, this);
+    sram->attach(ADMUX, this);
+}
+
+//13 ADC clocks, 25 for the first conversion after enabling
+uint64_t Adc::conversionCycles() const{
+    uint64_t clocks = firstConversion ? 25 : 13;
+    return clocks * ADC_DIVIDERS[adcsra & 0x07];
+}
+
+void Adc::start(uint64_t at){
+    converting = true;
+    done = at + conversionCycles();
+    firstConversion = false;
+    adcsra |= ADSC;
+}
+
+void Adc::complete(){
+    result = inputs[admux & 0x0F] & 0x03FF;
+    adcsra |= ADIF;
+}
+
+void Adc::sync(uint64_t now){
+    if(!converting || now < done){
+        return;
+    }
+    //Free running (ADATE with ADTS = 0) keeps converting back to back; jump
+    //straight to the last conversion that finished
+    if((adcsra & ADATE) && (adcsrb & 0x07) == 0){
+        uint64_t period = conversionCycles();
+        done += ((now - done) / period + 1) * period;
+        complete();
+        return;
+    }
+    converting = false;
+    adcsra &= ~ADSC;
+    complete();
+}
+
+uint64_t Adc::nextDeadline() const{
+    if(converting && (adcsra & ADIE) && !(adcsra & ADIF)){
+        return done;
+    }
+    return UINT64_MAX;
+}
+
+uint8_t Adc::read(uint16_t addr){
+    sync(now());
+    bool leftAdjust = admux & 0x20;
+    uint16_t value = leftAdjust ? (result << 6) : result;
+    switch(addr){
+        case ADCL:
+            latchedHigh = value >> 8;
+            latched = true;
+            return value & 0xFF;
+        case ADCH:
+            //ADCL then ADCH reads one result; ADCH alone (ADLAR 8-bit reads) is live
+            if(latched){
+                latched = false;
+                return latchedHigh;
+            }
+            return value >> 8;
+        case ADCSRA:
+            return adcsra;
+        case ADCSRB:
+            return adcsrb;
+        default:
+            return admux;
+    }
+}
+
+void Adc::write(uint16_t addr, uint8_t val){
+    sync(now());
+    switch(addr){
+        case ADCSRA: {
+            bool startRequested = (val & ADSC) && (val & ADEN) && !converting;
+            if(!(val & ADEN)){
+                converting = false;
+                firstConversion = true;
+            }
+            uint8_t adif = ((adcsra & ADIF) && !(val & ADIF)) ? ADIF : 0; //Cleared by writing a one
+            uint8_t adsc = converting ? ADSC : 0;
+            adcsra = (val & ~(ADIF | ADSC)) | adif | adsc;
+            if(startRequested) start(now());
+            break;
+        }
+        case ADCSRB:
+            adcsrb = val;
+            break;
+        case ADMUX:
+            admux = val;
+            break;
+        default:
+            break; //ADCL/ADCH are read only
+    }
+}
+
+void Adc::setInput(uint8_t channel, uint16_t value){
+    if(channel >= ADC_CHANNELS){
+        throw std::out_of_range("Invalid ADC channel");
+    }
+    sync(now());
+    inputs[channel] = value;
+}
+
+bool Adc::interruptPending() const{
+    return (adcsra & ADIF) && (adcsra & ADIE);
+}
+
+std::unique_ptr<IoDevice> Adc::save() const{
+    return std::make_unique<Adc>(*this);
+}
+
+void Adc::restore(const IoDevice& saved){
+    *this = static_cast<const Adc&>(saved);
+}
@@ -0,0 +1,92 @@
+#include "Gpio.hpp"
+#include "SRAM.hpp"
+#include <stdexcept>
+
+Gpio::Gpio(){
+    trace = nullptr;
+    for(Port& p : ports){
+        p = Port{0, 0, 0, 0};
+    }
+}
+
+//Pins go back to inputs; what drives them from outside stays
+void Gpio::reset(){
+    for(uint8_t i = 0; i < NUM_PORTS; i++){
+        ports[i].ddr = 0;
+        ports[i].port = 0;
+        update(i);
+    }
+}
+
+void Gpio::attach(SRAM* sram){
+    for(uint16_t addr = PINB; addr <= PORTD; addr++){
+        sram->attach(addr, this);
+    }
+}
+
+//Level seen on the pins: driven bits come from PORTx, the rest from outside
+void Gpio::update(uint8_t index){
+    Port& p = ports[index];
+    uint8_t level = (p.port & p.ddr) | (p.input & ~p.ddr);
+    if(level == p.level){
+        return;
+    }
+    p.level = level;
+    if(trace){
+        trace->push({now(), index, level});
+    }
+}
+
+uint8_t Gpio::read(uint16_t addr){
+    uint8_t index = (addr - PINB) / 3;
+    const Port& p = ports[index];
+    switch((addr - PINB) % 3){
+        case 0: return p.level;
+        case 1: return p.ddr;
+        default: return p.port;
+    }
+}
+
+void Gpio::write(uint16_t addr, uint8_t val){
+    uint8_t index = (addr - PINB) / 3;
+    Port& p = ports[index];
+    switch((addr - PINB) % 3){
+        case 0: // Writing a one to PINx toggles PORTx
+            p.port ^= val;
+            break;
+        case 1:
+            p.ddr = val;
+            break;
+        default:
+            p.port = val;
+            break;
+    }
+    update(index);
+}
+
+void Gpio::setInput(uint8_t port, uint8_t value){
+    if(port >= NUM_PORTS){
+        throw std::out_of_range("Invalid port");
+    }
+    ports[port].input = value;
+    update(port);
+}
+
+uint8_t Gpio::getLevel(uint8_t port) const{
+    if(port >= NUM_PORTS){
+        throw std::out_of_range("Invalid port");
+    }
+    return ports[port].level;
+}
+
+void Gpio::setTrace(PinEventRing* trace){
+    this->trace = trace;
+}
+
+std::unique_ptr<IoDevice> Gpio::save() const{
+    return std::make_unique<Gpio>(*this);
+}
+
+void Gpio::restore(const IoDevice& saved){
+    *this = static_cast<const Gpio&>(saved);
+}
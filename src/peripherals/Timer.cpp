@@ -0,0 +1,331 @@
+#include "Timer.hpp"
+#include "SRAM.hpp"
+#include <algorithm>
+
+struct WgmEntry {
+    TimerMode mode;
+    TimerTop top;
+};
+
+static constexpr WgmEntry WGM8[8] = {
+    {TimerMode::Normal, TimerTop::Max},
+    {TimerMode::PhaseCorrect, TimerTop::Max},
+    {TimerMode::CTC, TimerTop::OCRA},
+    {TimerMode::Fast, TimerTop::Max},
+    {TimerMode::Normal, TimerTop::Max}, //Reserved
+    {TimerMode::PhaseCorrect, TimerTop::OCRA},
+    {TimerMode::Normal, TimerTop::Max}, //Reserved
+    {TimerMode::Fast, TimerTop::OCRA}
+};
+
+static constexpr WgmEntry WGM16[16] = {
+    {TimerMode::Normal, TimerTop::Max},
+    {TimerMode::PhaseCorrect, TimerTop::Fixed8},
+    {TimerMode::PhaseCorrect, TimerTop::Fixed9},
+    {TimerMode::PhaseCorrect, TimerTop::Fixed10},
+    {TimerMode::CTC, TimerTop::OCRA},
+    {TimerMode::Fast, TimerTop::Fixed8},
+    {TimerMode::Fast, TimerTop::Fixed9},
+    {TimerMode::Fast, TimerTop::Fixed10},
+    {TimerMode::PhaseCorrect, TimerTop::ICR}, //Phase and frequency correct
+    {TimerMode::PhaseCorrect, TimerTop::OCRA}, //Phase and frequency correct
+    {TimerMode::PhaseCorrect, TimerTop::ICR},
+    {TimerMode::PhaseCorrect, TimerTop::OCRA},
+    {TimerMode::CTC, TimerTop::ICR},
+    {TimerMode::Normal, TimerTop::Max}, //Reserved
+    {TimerMode::Fast, TimerTop::ICR},
+    {TimerMode::Fast, TimerTop::OCRA}
+};
+
+Timer::Timer(const TimerConfig& config) : config(config){
+    reset();
+}
+
+void Timer::reset(){
+    tccra = 0;
+    tccrb = 0;
+    tcnt = 0;
+    ocra = 0;
+    ocrb = 0;
+    icr = 0;
+    tifr = 0;
+    timsk = 0;
+    temp = 0;
+    down = false;
+    lastSync = now();
+    residual = 0;
+}
+
+void Timer::rebase(uint64_t now){
+    lastSync = now;
+}
+
+void Timer::attach(SRAM* sram){
+    sram->attach(config.tccra, this);
+    sram->attach(config.tccrb, this);
+    sram->attach(config.tcnt, this);
+    sram->attach(config.ocra, this);
+    sram->attach(config.ocrb, this);
+    sram->attach(config.tifr, this);
+    sram->attach(config.timsk, this);
+    if(config.wide){
+        sram->attach(config.tccra + 2, this); //TCCR1C
+        sram->attach(config.tcnt + 1, this);
+        sram->attach(config.ocra + 1, this);
+        sram->attach(config.ocrb + 1, this);
+        sram->attach(config.icr, this);
+        sram->attach(config.icr + 1, this);
+    }
+}
+
+uint8_t Timer::wgm() const{
+    if(config.wide){
+        return (tccra & 0x03) | ((tccrb & 0x18) >> 1);
+    }
+    return (tccra & 0x03) | ((tccrb & 0x08) >> 1);
+}
+
+TimerMode Timer::mode() const{
+    return config.wide ? WGM16[wgm()].mode : WGM8[wgm()].mode;
+}
+
+uint16_t Timer::max() const{
+    return config.wide ? 0xFFFF : 0xFF;
+}
+
+uint16_t Timer::top() const{
+    switch(config.wide ? WGM16[wgm()].top : WGM8[wgm()].top){
+        case TimerTop::Fixed8: return 0x00FF;
+        case TimerTop::Fixed9: return 0x01FF;
+        case TimerTop::Fixed10: return 0x03FF;
+        case TimerTop::OCRA: return ocra;
+        case TimerTop::ICR: return icr;
+        default: return max();
+    }
+}
+
+uint16_t Timer::prescaler() const{
+    return config.prescalers[tccrb & 0x07];
+}
+
+//Number of timer ticks before the counter is back where it started
+uint64_t Timer::period() const{
+    uint64_t t = top();
+    if(mode() == TimerMode::PhaseCorrect){
+        return t ? 2 * t : 1;
+    }
+    return t + 1;
+}
+
+//Up-counting modes walk 0..TOP, phase correct walks 0..TOP..1; position is the
+//index into that walk so every mode can be advanced with one modulo
+uint64_t Timer::position() const{
+    uint64_t t = top();
+    uint64_t count = std::min<uint64_t>(tcnt, t);
+    if(mode() == TimerMode::PhaseCorrect && down){
+        return (2 * t - count) % period();
+    }
+    return count;
+}
+
+void Timer::setPosition(uint64_t p){
+    uint64_t t = top();
+    if(mode() == TimerMode::PhaseCorrect && p > t){
+        tcnt = static_cast<uint16_t>(2 * t - p);
+        down = true;
+    }else{
+        tcnt = static_cast<uint16_t>(p);
+        down = false;
+    }
+}
+
+//Compare and TOP flags are set on the timer clock after the match (OCR -> OCR+1,
+//TOP -> BOTTOM), so those events sit one position past the matching count
+size_t Timer::events(std::array<Event,6>& out) const{
+    size_t n = 0;
+    uint64_t t = top();
+    uint64_t p = period();
+    TimerMode m = mode();
+
+    if(m != TimerMode::CTC || t == max()){
+        out[n++] = {0, TOV};
+    }
+    if(ocra <= t){
+        out[n++] = {(ocra + 1) % p, OCFA};
+        if(m == TimerMode::PhaseCorrect) out[n++] = {(2 * t - ocra + 1) % p, OCFA};
+    }
+    if(ocrb <= t){
+        out[n++] = {(ocrb + 1) % p, OCFB};
+        if(m == TimerMode::PhaseCorrect) out[n++] = {(2 * t - ocrb + 1) % p, OCFB};
+    }
+    if(config.wide && (WGM16[wgm()].top == TimerTop::ICR)){
+        out[n++] = {(t + 1) % p, ICF};
+    }
+    return n;
+}
+
+//Ticks needed to move from one position onto another, a full period if they are equal
+uint64_t Timer::ticksUntil(uint64_t from, uint64_t event) const{
+    uint64_t p = period();
+    return ((event + p - from - 1) % p) + 1;
+}
+
+//Above TOP the counter runs on to MAX, still matching any OCR it passes on the
+//way; UINT64_MAX if the OCR is already behind the count
+uint64_t Timer::ticksToMatch(uint16_t ocr) const{
+    return ocr >= tcnt ? static_cast<uint64_t>(ocr) - tcnt + 1 : UINT64_MAX;
+}
+
+void Timer::advance(uint64_t ticks){
+    if(ticks == 0){
+        return;
+    }
+    //OCRnA was moved below the count: run up to MAX and wrap first
+    if(mode() != TimerMode::PhaseCorrect && tcnt > top()){
+        uint64_t toWrap = static_cast<uint64_t>(max()) - tcnt + 1;
+        uint64_t run = std::min(ticks, toWrap);
+        if(ticksToMatch(ocra) <= run) tifr |= OCFA;
+        if(ticksToMatch(ocrb) <= run) tifr |= OCFB;
+        if(ticks < toWrap){
+            tcnt = static_cast<uint16_t>(tcnt + ticks);
+            return;
+        }
+        ticks -= toWrap;
+        tcnt = 0;
+        tifr |= TOV;
+        if(ticks == 0) return;
+    }
+
+    uint64_t from = position();
+    std::array<Event,6> list;
+    size_t n = events(list);
+    for(size_t i = 0; i < n; i++){
+        if(ticksUntil(from, list[i].position) <= ticks){
+            tifr |= list[i].flag;
+        }
+    }
+    setPosition((from + ticks) % period());
+}
+
+void Timer::sync(uint64_t now){
+    if(now <= lastSync){
+        return;
+    }
+    uint64_t elapsed = now - lastSync;
+    lastSync = now;
+    uint16_t n = prescaler();
+    if(n == 0){
+        return;
+    }
+    uint64_t total = residual + elapsed;
+    residual = total % n;
+    advance(total / n);
+}
+
+uint64_t Timer::nextDeadline() const{
+    uint16_t n = prescaler();
+    uint8_t enabled = timsk & ~tifr & (TOV | OCFA | OCFB | ICF);
+    if(n == 0 || enabled == 0){
+        return UINT64_MAX;
+    }
+    uint64_t ticks = UINT64_MAX;
+    if(mode() != TimerMode::PhaseCorrect && tcnt > top()){
+        ticks = static_cast<uint64_t>(max()) - tcnt + 1;
+        if(enabled & OCFA) ticks = std::min(ticks, ticksToMatch(ocra));
+        if(enabled & OCFB) ticks = std::min(ticks, ticksToMatch(ocrb));
+    }else{
+        uint64_t from = position();
+        std::array<Event,6> list;
+        size_t count = events(list);
+        for(size_t i = 0; i < count; i++){
+            if(list[i].flag & enabled){
+                ticks = std::min(ticks, ticksUntil(from, list[i].position));
+            }
+        }
+    }
+    if(ticks == UINT64_MAX){
+        return UINT64_MAX;
+    }
+    return lastSync + ticks * n - residual;
+}
+
+bool Timer::interruptPending() const{
+    return (tifr & timsk & (TOV | OCFA | OCFB | ICF)) != 0;
+}
+
+uint16_t Timer::getCount(){
+    sync(now());
+    return tcnt;
+}
+
+uint8_t Timer::read(uint16_t addr){
+    sync(now());
+    if(addr == config.tccra) return tccra;
+    if(addr == config.tccrb) return tccrb;
+    if(addr == config.tifr) return tifr;
+    if(addr == config.timsk) return timsk;
+    if(!config.wide){
+        if(addr == config.tcnt) return static_cast<uint8_t>(tcnt);
+        if(addr == config.ocra) return static_cast<uint8_t>(ocra);
+        if(addr == config.ocrb) return static_cast<uint8_t>(ocrb);
+        return 0;
+    }
+    //Reading the low byte of TCNT1/ICR1 latches the high byte into TEMP
+    if(addr == config.tcnt){
+        temp = tcnt >> 8;
+        return tcnt & 0xFF;
+    }
+    if(addr == config.icr){
+        temp = icr >> 8;
+        return icr & 0xFF;
+    }
+    if(addr == config.tcnt + 1 || addr == config.icr + 1) return temp;
+    if(addr == config.ocra) return ocra & 0xFF;
+    if(addr == config.ocra + 1) return ocra >> 8;
+    if(addr == config.ocrb) return ocrb & 0xFF;
+    if(addr == config.ocrb + 1) return ocrb >> 8;
+    return 0;
+}
+
+void Timer::write(uint16_t addr, uint8_t val){
+    //Everything up to now happened under the old settings
+    sync(now());
+    if(addr == config.tccra){
+        tccra = val;
+    }else if(addr == config.tccrb){
+        tccrb = config.wide ? val : (val & 0x3F); //FOC bits are strobes
+    }else if(addr == config.tifr){
+        tifr &= ~val; //Flags are cleared by writing a one
+    }else if(addr == config.timsk){
+        timsk = val;
+    }else if(!config.wide){
+        if(addr == config.tcnt){
+            tcnt = val;
+            down = false;
+        }else if(addr == config.ocra){
+            ocra = val;
+        }else if(addr == config.ocrb){
+            ocrb = val;
+        }
+    }else if(addr == config.tcnt + 1 || addr == config.ocra + 1 || addr == config.ocrb + 1 || addr == config.icr + 1){
+        //High byte waits in TEMP until the low byte is written
+        temp = val;
+    }else if(addr == config.tcnt){
+        tcnt = (temp << 8) | val;
+        down = false;
+    }else if(addr == config.ocra){
+        ocra = (temp << 8) | val;
+    }else if(addr == config.ocrb){
+        ocrb = (temp << 8) | val;
+    }else if(addr == config.icr){
+        icr = (temp << 8) | val;
+    }
+}
+
+std::unique_ptr<IoDevice> Timer::save() const{
+    return std::make_unique<Timer>(*this);
+}
+
+void Timer::restore(const IoDevice& saved){
+    *this = static_cast<const Timer&>(saved);
+}
@@ -0,0 +1,100 @@
+#include "Usart.hpp"
+#include "SRAM.hpp"
+
+Usart::Usart(){
+    reset();
+}
+
+void Usart::reset(){
+    ucsra = 0;
+    ucsrb = 0;
+    ucsrc = 0x06; //8N1
+    ubrrl = 0;
+    ubrrh = 0;
+    rxData = 0;
+    rxFull = false;
+    txComplete = false;
+}
+
+void Usart::attach(SRAM* sram){
+    sram->attach(UCSR0A, this);
+    sram->attach(UCSR0B, this);
+    sram->attach(UCSR0C, this);
+    sram->attach(UBRR0L, this);
+    sram->attach(UBRR0H, this);
+    sram->attach(UDR0, this);
+}
+
+//Pulls the next byte into the receive register once the previous one was read
+void Usart::poll(){
+    if(!rxFull && rxSource && rxSource(now(), rxData)){
+        rxFull = true;
+    }
+}
+
+uint8_t Usart::read(uint16_t addr){
+    switch(addr){
+        case UCSR0A:
+            poll();
+            return (rxFull ? RXC0 : 0) | (txComplete ? TXC0 : 0) | UDRE0 | (ucsra & 0x03);
+        case UCSR0B:
+            return ucsrb;
+        case UCSR0C:
+            return ucsrc;
+        case UBRR0L:
+            return ubrrl;
+        case UBRR0H:
+            return ubrrh;
+        default:
+            //Reading UDR0 with nothing received returns the last byte again
+            poll();
+            rxFull = false;
+            return rxData;
+    }
+}
+
+void Usart::write(uint16_t addr, uint8_t val){
+    switch(addr){
+        case UCSR0A:
+            if(val & TXC0) txComplete = false; //Cleared by writing a one
+            ucsra = val & 0x03; //U2X0, MPCM0
+            break;
+        case UCSR0B:
+            ucsrb = val;
+            break;
+        case UCSR0C:
+            ucsrc = val;
+            break;
+        case UBRR0L:
+            ubrrl = val;
+            break;
+        case UBRR0H:
+            ubrrh = val & 0x0F;
+            break;
+        default:
+            if(txSink) txSink(now(), val);
+            txComplete = true;
+            break;
+    }
+}
+
+void Usart::setRxSource(const RxSource& source){
+    rxSource = source;
+}
+
+void Usart::setTxSink(const TxSink& sink){
+    txSink = sink;
+}
+
+//A byte has been taken from the source but not read from UDR0 yet
+bool Usart::rxPending() const{
+    return rxFull;
+}
+
+std::unique_ptr<IoDevice> Usart::save() const{
+    return std::make_unique<Usart>(*this);
+}
+
+void Usart::restore(const IoDevice& saved){
+    *this = static_cast<const Usart&>(saved);
+}
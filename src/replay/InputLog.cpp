@@ -0,0 +1,132 @@
+#include "InputLog.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr char LOG_MAGIC[8] = {'A', 'V', 'R', 'I', 'N', 'L', 'O', 'G'};
+static constexpr size_t MIN_EVENT_BYTES = 3; //Delta, tag and value varints
+
+InputLog::InputLog(){
+    clear();
+}
+
+void InputLog::clear(){
+    bytes.clear();
+    lastCycle = 0;
+    events = 0;
+}
+
+void InputLog::putVarint(uint64_t value){
+    while(value >= 0x80){
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+void InputLog::append(const InputEvent& event){
+    if(event.cycle < lastCycle){
+        throw std::invalid_argument("Input events must be recorded in cycle order");
+    }
+    putVarint(event.cycle - lastCycle);
+    putVarint((static_cast<uint64_t>(event.channel) << 2) | static_cast<uint8_t>(event.kind));
+    putVarint(event.value);
+    lastCycle = event.cycle;
+    events++;
+}
+
+size_t InputLog::size() const{
+    return events;
+}
+
+size_t InputLog::byteSize() const{
+    return bytes.size();
+}
+
+InputLog::Reader InputLog::reader() const{
+    return Reader(this);
+}
+
+InputLog::Reader::Reader(const InputLog* log){
+    this->log = log;
+    this->offset = 0;
+    this->cycle = 0;
+}
+
+bool InputLog::Reader::getVarint(uint64_t& value){
+    value = 0;
+    for(unsigned shift = 0; offset < log->bytes.size() && shift < 64; shift += 7){
+        uint8_t byte = log->bytes[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if(!(byte & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InputLog::Reader::next(InputEvent& event){
+    uint64_t delta, tag, value;
+    if(!getVarint(delta) || !getVarint(tag) || !getVarint(value)){
+        return false;
+    }
+    cycle += delta;
+    event.cycle = cycle;
+    event.kind = static_cast<InputKind>(tag & 0x03);
+    event.channel = static_cast<uint8_t>(tag >> 2);
+    event.value = static_cast<uint16_t>(value);
+    return true;
+}
+
+void InputLog::save(const std::string& path) const{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if(!file){
+        throw std::runtime_error("Cannot open " + path);
+    }
+    uint64_t header[2] = {static_cast<uint64_t>(events), lastCycle};
+    bool ok = std::fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), file) == sizeof(LOG_MAGIC)
+        && std::fwrite(header, sizeof(header), 1, file) == 1
+        && std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if(!ok){
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void InputLog::load(const std::string& path){
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if(!file){
+        throw std::runtime_error("Cannot open " + path);
+    }
+    char magic[8];
+    uint64_t header[2];
+    if(std::fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+        || std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0
+        || std::fread(header, sizeof(header), 1, file) != 1){
+        std::fclose(file);
+        throw std::runtime_error("Not an input log: " + path);
+    }
+    //Every event takes at least one byte per field, so a count the payload
+    //cannot hold means a damaged file; check before sizing anything from it
+    long start = std::ftell(file);
+    long end = (start >= 0 && std::fseek(file, 0, SEEK_END) == 0) ? std::ftell(file) : -1;
+    if(end < start || std::fseek(file, start, SEEK_SET) != 0){
+        std::fclose(file);
+        throw std::runtime_error("Cannot read " + path);
+    }
+    size_t payload = static_cast<size_t>(end - start);
+    if(header[0] > payload / MIN_EVENT_BYTES){
+        std::fclose(file);
+        throw std::runtime_error("Corrupt input log (event count exceeds file size): " + path);
+    }
+    clear();
+    bytes.resize(payload);
+    bool ok = std::fread(bytes.data(), 1, payload, file) == payload;
+    std::fclose(file);
+    if(!ok){
+        clear();
+        throw std::runtime_error("Cannot read " + path);
+    }
+    events = static_cast<size_t>(header[0]);
+    lastCycle = header[1];
+}
@@ -0,0 +1,29 @@
+#include "InputRecorder.hpp"
+
+InputRecorder::InputRecorder(CPU* cpu, const InputSinks& sinks, InputLog* log){
+    this->cpu = cpu;
+    this->sinks = sinks;
+    this->log = log;
+}
+
+void InputRecorder::deliver(InputKind kind, uint8_t channel, uint16_t value){
+    InputEvent event{cpu->getCycles(), kind, channel, value};
+    if(log) log->append(event);
+    sinks.apply(event);
+}
+
+void InputRecorder::usartRx(uint8_t usart, uint8_t byte){
+    deliver(InputKind::UsartRx, usart, byte);
+}
+
+void InputRecorder::pinChange(uint8_t port, uint8_t value){
+    deliver(InputKind::PinChange, port, value);
+}
+
+void InputRecorder::adcSample(uint8_t channel, uint16_t value){
+    deliver(InputKind::AdcSample, channel, value);
+}
+
+void InputRecorder::interrupt(uint8_t vector){
+    deliver(InputKind::Interrupt, vector, 0);
+}
@@ -0,0 +1,41 @@
+#include "InputReplayer.hpp"
+#include <algorithm>
+
+InputReplayer::InputReplayer(const InputLog* log, const InputSinks& sinks) : sinks(sinks), reader(log->reader()){
+    hasPending = reader.next(pending);
+}
+
+uint8_t InputReplayer::read(uint16_t){
+    return 0;
+}
+
+void InputReplayer::write(uint16_t, uint8_t){}
+
+void InputReplayer::sync(uint64_t now){
+    while(hasPending && pending.cycle <= now){
+        sinks.apply(pending);
+        hasPending = reader.next(pending);
+    }
+}
+
+uint64_t InputReplayer::nextDeadline() const{
+    return hasPending ? pending.cycle : UINT64_MAX;
+}
+
+bool InputReplayer::finished() const{
+    return !hasPending;
+}
+
+void InputReplayer::run(CPU& cpu, uint64_t untilCycle, uint64_t traceFrom,
+                        const std::function<void(uint64_t cycle, uint16_t pc)>& trace){
+    //Events stamped before the first instruction
+    sync(cpu.getCycles());
+    uint64_t fastUntil = trace ? std::min(untilCycle, traceFrom) : untilCycle;
+    while(cpu.getCycles() < fastUntil){
+        cpu.step(cpu);
+    }
+    while(cpu.getCycles() < untilCycle){
+        trace(cpu.getCycles(), cpu.getProgramCounter().get());
+        cpu.step(cpu);
+    }
+}
@@ -0,0 +1,47 @@
+#include "InputSinks.hpp"
+
+UsartInput::UsartInput(){
+    this->usart = nullptr;
+}
+
+UsartInput::~UsartInput(){
+    if(usart) usart->setRxSource(nullptr);
+}
+
+void UsartInput::attach(Usart* usart){
+    if(this->usart) this->usart->setRxSource(nullptr);
+    this->usart = usart;
+    usart->setRxSource([this](uint64_t, uint8_t& byte){
+        if(pending.empty()){
+            return false;
+        }
+        byte = pending.front();
+        pending.pop_front();
+        return true;
+    });
+}
+
+void UsartInput::push(uint8_t byte){
+    pending.push_back(byte);
+}
+
+size_t UsartInput::size() const{
+    return pending.size();
+}
+
+void InputSinks::apply(const InputEvent& event) const{
+    switch(event.kind){
+        case InputKind::UsartRx:
+            if(usart && event.channel == 0) usart->push(static_cast<uint8_t>(event.value));
+            break;
+        case InputKind::PinChange:
+            if(gpio) gpio->setInput(event.channel, static_cast<uint8_t>(event.value));
+            break;
+        case InputKind::AdcSample:
+            if(adc) adc->setInput(event.channel, event.value);
+            break;
+        case InputKind::Interrupt:
+            if(interrupt) interrupt(event.channel);
+            break;
+    }
+}
@@ -0,0 +1,144 @@
+#include "CoSimulator.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+CoSimulator::CoSimulator(){
+    waiting = 0;
+    generation = 0;
+    horizon = 0;
+    end = 0;
+    finished = false;
+    failed = false;
+}
+
+size_t CoSimulator::addMcu(CPU* cpu){
+    mcus.push_back(cpu);
+    usarts.push_back(std::make_unique<Usart>());
+    usarts.back()->attach(&cpu->getSRAM());
+    sending.push_back(false);
+    receiving.push_back(false);
+    return mcus.size() - 1;
+}
+
+//The sender's UDR0 writes go into the link, the receiver's UDR0 reads come out
+//of it. Both callbacks run on the thread of the MCU that owns the USART.
+Link* CoSimulator::connect(size_t from, size_t to, uint64_t latency){
+    if(from >= mcus.size() || to >= mcus.size()){
+        throw std::out_of_range("Invalid MCU index");
+    }
+    if(sending[from] || receiving[to]){
+        throw std::invalid_argument("USART0 already has a link");
+    }
+    links.push_back(std::make_unique<Link>(latency));
+    Link* link = links.back().get();
+    usarts[from]->setTxSink([link](uint64_t now, uint8_t byte){
+        link->send(now, byte);
+    });
+    usarts[to]->setRxSource([link](uint64_t now, uint8_t& byte){
+        return link->receive(now, byte);
+    });
+    sending[from] = true;
+    receiving[to] = true;
+    return link;
+}
+
+Usart& CoSimulator::getUsart(size_t mcu){
+    if(mcu >= mcus.size()){
+        throw std::out_of_range("Invalid MCU index");
+    }
+    return *usarts[mcu];
+}
+
+//A byte sent during a quantum arrives at least one latency later, so as long as
+//the quantum plus the overshoot of the last instruction stays under the smallest
+//latency no MCU can observe a byte that has not been delivered yet.
+uint64_t CoSimulator::quantum() const{
+    if(links.empty()){
+        return UINT64_MAX;
+    }
+    uint64_t minLatency = UINT64_MAX;
+    for(const auto& link : links){
+        minLatency = std::min(minLatency, link->getLatency());
+    }
+    return minLatency > MAX_INSTRUCTION_CYCLES ? minLatency - MAX_INSTRUCTION_CYCLES : 1;
+}
+
+uint64_t CoSimulator::getQuantum() const{
+    return quantum();
+}
+
+//Last thread to arrive flushes the links and opens the next quantum
+bool CoSimulator::barrier(){
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t gen = generation;
+    if(++waiting == mcus.size()){
+        for(auto& link : links){
+            link->deliver();
+        }
+        if(horizon >= end){
+            finished = true;
+        }else{
+            uint64_t q = quantum();
+            horizon = (end - horizon > q) ? horizon + q : end;
+        }
+        waiting = 0;
+        generation++;
+        cv.notify_all();
+    }else{
+        cv.wait(lock, [this, gen](){ return generation != gen; });
+    }
+    return !failed && !finished;
+}
+
+void CoSimulator::worker(CPU* cpu){
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target = horizon;
+    }
+    while(true){
+        try{
+            while(!failed && cpu->getCycles() < target){
+                cpu->step(*cpu);
+            }
+        }catch(...){
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!error) error = std::current_exception();
+            failed = true;
+        }
+        if(!barrier()){
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        target = horizon;
+    }
+}
+
+void CoSimulator::run(uint64_t cycles){
+    if(mcus.empty()){
+        return;
+    }
+    uint64_t start = mcus[0]->getCycles();
+    for(CPU* cpu : mcus){
+        start = std::min(start, cpu->getCycles());
+    }
+    uint64_t q = quantum();
+    end = start + cycles;
+    horizon = (cycles > q) ? start + q : end;
+    waiting = 0;
+    finished = false;
+    failed = false;
+    error = nullptr;
+
+    std::vector<std::thread> threads;
+    for(CPU* cpu : mcus){
+        threads.emplace_back(&CoSimulator::worker, this, cpu);
+    }
+    for(auto& thread : threads){
+        thread.join();
+    }
+    if(error){
+        std::rethrow_exception(error);
+    }
+}
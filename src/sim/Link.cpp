@@ -0,0 +1,38 @@
+#include "Link.hpp"
+#include <stdexcept>
+
+Link::Link(uint64_t latency){
+    if(latency == 0){
+        throw std::invalid_argument("Link latency must be at least one cycle");
+    }
+    this->latency = latency;
+}
+
+void Link::send(uint64_t cycle, uint8_t value){
+    outbox.push_back({cycle + latency, value});
+}
+
+bool Link::receive(uint64_t now, uint8_t& value){
+    if(inbox.empty() || inbox.front().arrival > now){
+        return false;
+    }
+    value = inbox.front().value;
+    inbox.pop_front();
+    return true;
+}
+
+//Only called while every MCU is parked at the barrier
+void Link::deliver(){
+    for(const LinkByte& byte : outbox){
+        inbox.push_back(byte);
+    }
+    outbox.clear();
+}
+
+uint64_t Link::getLatency() const{
+    return latency;
+}
+
+uint64_t Link::uartByteCycles(uint32_t baud, uint32_t clockHz, uint32_t frameBits){
+    return (static_cast<uint64_t>(clockHz) * frameBits + baud - 1) / baud;
+}
@@ -0,0 +1,28 @@
+#include "PinEventRing.hpp"
+
+PinEventRing::PinEventRing() : head(0), tail(0), drops(0) {}
+
+bool PinEventRing::push(const PinEvent& event){
+    size_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) == RING_SIZE){
+        drops.store(drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    events[h % RING_SIZE] = event;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool PinEventRing::pop(PinEvent& event){
+    size_t t = tail.load(std::memory_order_relaxed);
+    if(t == head.load(std::memory_order_acquire)){
+        return false;
+    }
+    event = events[t % RING_SIZE];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t PinEventRing::getDrops() const{
+    return drops.load(std::memory_order_relaxed);
+}
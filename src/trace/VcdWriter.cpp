@@ -0,0 +1,128 @@
+#include "VcdWriter.hpp"
+#include <chrono>
+#include <stdexcept>
+#ifdef EMU_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+static const char* PORT_IDS[] = {"!", "\"", "#"};
+static const char* PORT_NAMES[] = {"PINB", "PINC", "PIND"}; //Pin levels, not the PORTx latches
+static constexpr size_t NUM_VCD_PORTS = 3;
+
+static std::string binary(uint8_t value){
+    std::string text = "b";
+    for(int bit = 7; bit >= 0; bit--){
+        text += ((value >> bit) & 1) ? '1' : '0';
+    }
+    return text;
+}
+
+VcdWriter::VcdWriter(PinEventRing* ring, const Gpio& pins, const std::string& path, uint32_t clockHz){
+    this->ring = ring;
+    this->psPerCycle = 1000000000000ULL / clockHz;
+    this->file = nullptr;
+    this->gz = nullptr;
+    this->running = false;
+    this->lastCycle = 0;
+    this->first = true;
+    this->drops = 0;
+
+    bool compress = path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+    if(compress){
+#ifdef EMU_HAVE_ZLIB
+        gz = gzopen(path.c_str(), "wb");
+#else
+        throw std::runtime_error("Built without zlib, cannot write " + path);
+#endif
+    }else{
+        file = std::fopen(path.c_str(), "w");
+    }
+    if(!file && !gz){
+        throw std::runtime_error("Cannot open " + path);
+    }
+    writeHeader(pins);
+}
+
+VcdWriter::~VcdWriter(){
+    stop();
+#ifdef EMU_HAVE_ZLIB
+    if(gz) gzclose(static_cast<gzFile>(gz));
+#endif
+    if(file) std::fclose(file);
+}
+
+void VcdWriter::emit(const std::string& text){
+#ifdef EMU_HAVE_ZLIB
+    if(gz){
+        gzwrite(static_cast<gzFile>(gz), text.data(), static_cast<unsigned>(text.size()));
+        return;
+    }
+#endif
+    std::fwrite(text.data(), 1, text.size(), file);
+}
+
+void VcdWriter::writeHeader(const Gpio& pins){
+    std::string header = "$timescale 1ps $end\n$scope module atmega328p $end\n";
+    for(size_t i = 0; i < NUM_VCD_PORTS; i++){
+        header += std::string("$var wire 8 ") + PORT_IDS[i] + " " + PORT_NAMES[i] + " $end\n";
+    }
+    header += "$upscope $end\n$enddefinitions $end\n";
+    //Without initial values viewers show X until each port first changes
+    header += "$dumpvars\n";
+    for(size_t i = 0; i < NUM_VCD_PORTS; i++){
+        header += binary(pins.getLevel(static_cast<uint8_t>(i))) + " " + PORT_IDS[i] + "\n";
+    }
+    header += "$end\n";
+    emit(header);
+}
+
+void VcdWriter::writeEvent(const PinEvent& event){
+    std::string line;
+    if(first || event.cycle != lastCycle){
+        line += "#" + std::to_string(event.cycle * psPerCycle) + "\n";
+        lastCycle = event.cycle;
+        first = false;
+    }
+    line += binary(event.value) + " " + PORT_IDS[event.port] + "\n";
+    emit(line);
+}
+
+//Events lost to a full ring leave a gap in the waveform; the ring only drops
+//when full, so the gap follows the events just drained
+void VcdWriter::noteDrops(){
+    uint64_t total = ring->getDrops();
+    if(total != drops){
+        emit("$comment " + std::to_string(total - drops) + " pin events dropped $end\n");
+        drops = total;
+    }
+}
+
+void VcdWriter::loop(){
+    PinEvent event;
+    while(running.load(std::memory_order_relaxed)){
+        bool any = false;
+        while(ring->pop(event)){
+            writeEvent(event);
+            any = true;
+        }
+        noteDrops();
+        //Quiet pins cost one poll per millisecond
+        if(!any) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    while(ring->pop(event)){
+        writeEvent(event);
+    }
+    noteDrops();
+}
+
+void VcdWriter::start(){
+    if(running) return;
+    running = true;
+    thread = std::thread(&VcdWriter::loop, this);
+}
+
+void VcdWriter::stop(){
+    if(!running) return;
+    running = false;
+    thread.join();
+}
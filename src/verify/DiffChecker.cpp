@@ -0,0 +1,171 @@
+#include "DiffChecker.hpp"
+#include "OpcodeGenerator.hpp"
+#include "Fnv1a.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+DiffChecker::DiffChecker(Flash* flash, uint64_t interval)
+    : flash(flash), reference(flash, &referenceSram), optimized(flash, &optimizedSram){
+    if(interval == 0){
+        throw std::invalid_argument("Check interval must be at least one instruction");
+    }
+    this->interval = interval;
+    decodeTable.build(*flash, optimized.getInstructionDecoder());
+    fusion.build(*flash);
+    optimized.setDecodeTable(&decodeTable);
+    optimized.setFusion(&fusion);
+    divergence = {0, 0, ""};
+}
+
+void DiffChecker::reset(){
+    reference.reset();
+    optimized.reset();
+    divergence = {0, 0, ""};
+}
+
+//Registers, SREG, PC, SP, counters and the whole data space. The data space is
+//only 2.3 KB, cheaper to hash outright than to track which lines are dirty.
+uint64_t DiffChecker::hash(CPUState& state){
+    uint64_t h = fnv1a(state.regs.data(), 32);
+    h = fnv1a(state.sr.data(), 1, h);
+    h = fnv1a(state.pc.data(), sizeof(uint16_t), h);
+    h = fnv1a(&state.sp, sizeof(state.sp), h);
+    h = fnv1a(&state.cycles, sizeof(state.cycles), h);
+    h = fnv1a(&state.instructions, sizeof(state.instructions), h);
+    return fnv1a(state.data.data(), state.data.size(), h);
+}
+
+//An exception is part of the outcome: both engines must fail the same way
+DiffChecker::Outcome DiffChecker::advance(CPU& cpu, uint64_t count){
+    std::string error;
+    try{
+        cpu.runInstructions(cpu, count);
+    }catch(const std::exception& e){
+        error = e.what();
+    }
+    return {hash(cpu.getState()), error};
+}
+
+bool DiffChecker::run(uint64_t instructions){
+    uint64_t done = 0;
+    while(done < instructions){
+        uint64_t count = std::min(interval, instructions - done);
+        CPU::Snapshot referenceStart = reference.snapshot();
+        CPU::Snapshot optimizedStart = optimized.snapshot();
+        Outcome a = advance(reference, count);
+        Outcome b = advance(optimized, count);
+        if(a.hash != b.hash || a.error != b.error){
+            bisect(referenceStart, optimizedStart, count);
+            return false;
+        }
+        //Both stopped the same way, or PC ran off the end of Flash
+        if(!a.error.empty() || reference.getInstructions() - referenceStart.instructions < count){
+            return true;
+        }
+        done += count;
+    }
+    return true;
+}
+
+//Smallest k in (0, count] for which k instructions from the snapshots diverge
+void DiffChecker::bisect(const CPU::Snapshot& referenceStart, const CPU::Snapshot& optimizedStart, uint64_t count){
+    uint64_t low = 0, high = count;
+    while(high - low > 1){
+        uint64_t mid = low + (high - low) / 2;
+        reference.restore(referenceStart);
+        optimized.restore(optimizedStart);
+        Outcome a = advance(reference, mid);
+        Outcome b = advance(optimized, mid);
+        if(a.hash != b.hash || a.error != b.error){
+            high = mid;
+        }else{
+            low = mid;
+        }
+    }
+
+    //Leave both engines just after the divergent instruction for inspection
+    reference.restore(referenceStart);
+    optimized.restore(optimizedStart);
+    advance(reference, high - 1);
+    advance(optimized, high - 1);
+    divergence.instruction = reference.getInstructions();
+    divergence.pc = reference.getProgramCounter().get();
+    Outcome a = advance(reference, 1);
+    Outcome b = advance(optimized, 1);
+    divergence.detail = describe(reference.getState(), optimized.getState());
+    if(a.error != b.error){
+        divergence.detail += "reference: " + (a.error.empty() ? std::string("ok") : a.error)
+                           + ", optimized: " + (b.error.empty() ? std::string("ok") : b.error) + "\n";
+    }
+}
+
+std::string DiffChecker::describe(CPUState& a, CPUState& b){
+    std::string out;
+    char line[96];
+    for(int r = 0; r < 32; r++){
+        if(a.regs.data()[r] != b.regs.data()[r]){
+            std::snprintf(line, sizeof(line), "r%d: %02x != %02x\n", r, a.regs.data()[r], b.regs.data()[r]);
+            out += line;
+        }
+    }
+    if(*a.sr.data() != *b.sr.data()){
+        std::snprintf(line, sizeof(line), "SREG: %02x != %02x\n", *a.sr.data(), *b.sr.data());
+        out += line;
+    }
+    if(*a.pc.data() != *b.pc.data()){
+        std::snprintf(line, sizeof(line), "PC: %04x != %04x\n", *a.pc.data(), *b.pc.data());
+        out += line;
+    }
+    if(a.sp != b.sp){
+        std::snprintf(line, sizeof(line), "SP: %04x != %04x\n", a.sp, b.sp);
+        out += line;
+    }
+    if(a.cycles != b.cycles){
+        std::snprintf(line, sizeof(line), "cycles: %llu != %llu\n",
+                      static_cast<unsigned long long>(a.cycles), static_cast<unsigned long long>(b.cycles));
+        out += line;
+    }
+    for(size_t addr = 0; addr < a.data.size(); addr++){
+        if(a.data[addr] != b.data[addr]){
+            std::snprintf(line, sizeof(line), "data[%04zx]: %02x != %02x\n", addr, a.data[addr], b.data[addr]);
+            out += line;
+        }
+    }
+    return out;
+}
+
+const Divergence& DiffChecker::getDivergence() const{
+    return divergence;
+}
+
+CPU& DiffChecker::getReference(){
+    return reference;
+}
+
+CPU& DiffChecker::getOptimized(){
+    return optimized;
+}
+
+//Random full-Flash programs from the decoder table, each run from reset. The
+//retired counts tell a real soak from programs that fault right away.
+bool DiffChecker::soak(uint32_t seed, size_t programs, uint64_t instructions, Divergence& divergence, SoakStats& stats){
+    InstructionDecoder decoder;
+    OpcodeGenerator generator(&decoder, seed);
+    auto flash = std::make_unique<Flash>();
+    stats = {0, UINT64_MAX, 0};
+    for(size_t i = 0; i < programs; i++){
+        flash->load(generator.program(WORDS));
+        DiffChecker checker(flash.get());
+        if(!checker.run(instructions)){
+            divergence = checker.getDivergence();
+            return false;
+        }
+        uint64_t retired = checker.getReference().getInstructions();
+        stats.programs++;
+        stats.fewestRetired = std::min(stats.fewestRetired, retired);
+        stats.totalRetired += retired;
+    }
+    return true;
+}
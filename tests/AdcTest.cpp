@@ -0,0 +1,46 @@
+#include "Adc.hpp"
+#include "Check.hpp"
+
+//Conversion timing: 25 ADC clocks for the first conversion, 13 after that
+int main(){
+    uint64_t clock = 0;
+    Adc adc;
+    adc.setClock(&clock);
+    adc.setInput(0, 0x0201);
+    adc.setInput(1, 0x03FF);
+
+    adc.write(ADCSRA, ADEN | ADSC | ADIE | 0x07); //clk/128
+    check(adc.nextDeadline() == 25 * 128, "first conversion takes 25 ADC clocks");
+    clock = 25 * 128 - 1;
+    check(adc.read(ADCSRA) & ADSC, "ADSC stays set while converting");
+    check((adc.read(ADCSRA) & ADIF) == 0, "no ADIF before the conversion ends");
+    clock = 25 * 128;
+    uint8_t status = adc.read(ADCSRA);
+    check((status & ADSC) == 0 && (status & ADIF), "ADSC clears and ADIF sets when done");
+    check(adc.interruptPending(), "ADIE with ADIF is pending");
+    check(adc.read(ADCL) == 0x01, "ADCL holds the low byte");
+    check(adc.read(ADCH) == 0x02, "ADCH holds the high byte");
+
+    adc.write(ADCSRA, ADEN | ADIF | ADIE | 0x07); //Clear ADIF
+    check((adc.read(ADCSRA) & ADIF) == 0, "writing a one clears ADIF");
+    adc.write(ADMUX, 0x01);
+    clock = 5000;
+    adc.write(ADCSRA, ADEN | ADSC | ADIE | 0x07);
+    check(adc.nextDeadline() == 5000 + 13 * 128, "later conversions take 13 ADC clocks");
+    clock = 5000 + 13 * 128;
+    check(adc.read(ADCL) == 0xFF, "second conversion reads the selected channel");
+    adc.setInput(1, 0x0100);
+    check(adc.read(ADCH) == 0x03, "ADCH after ADCL belongs to the same result");
+
+    //With no ADCL read pending, ADCH reads the live result
+    adc.write(ADCSRA, ADEN | ADSC | 0x07);
+    clock += 13 * 128;
+    check(adc.read(ADCH) == 0x01, "ADCH without ADCL reads the new result");
+
+    //Disabling the ADC makes the next conversion a first one again
+    adc.write(ADCSRA, ADIF);
+    adc.write(ADCSRA, ADEN | ADSC | ADIE | 0x02); //clk/4
+    check(adc.nextDeadline() == clock + 25 * 4, "re-enabled ADC pays the first-conversion time");
+
+    return report();
+}
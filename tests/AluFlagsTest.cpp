@@ -0,0 +1,72 @@
+#include "cpu.hpp"
+#include "Check.hpp"
+
+static constexpr uint8_t FLAG_Z = 0x02;
+static constexpr uint8_t FLAG_C = 0x01;
+
+//16-bit compare of r25:r24 against r19:r18, then BREQ over an LDI r16,1
+static std::vector<uint16_t> compare16(uint8_t lowA, uint8_t highA, uint8_t lowB, uint8_t highB){
+    auto ldi = [](uint8_t rd, uint8_t k){
+        return static_cast<uint16_t>(0xE000 | ((k & 0xF0) << 4) | ((rd - 16) << 4) | (k & 0x0F));
+    };
+    return {
+        ldi(24, lowA),
+        ldi(25, highA),
+        ldi(18, lowB),
+        ldi(19, highB),
+        0x1782, // cp r24,r18
+        0x0793, // cpc r25,r19
+        0xF009, // breq .+2
+        0xE001  // ldi r16,1
+    };
+}
+
+//Returns r16: 0 if BREQ was taken
+static uint8_t runCompare(const std::vector<uint16_t>& program, bool fused){
+    Flash flash;
+    flash.load(program);
+    SRAM sram;
+    CPU cpu(&flash, &sram);
+    FusionTable fusion;
+    if(fused){
+        fusion.build(flash);
+        cpu.setFusion(&fusion);
+    }
+    while(cpu.getProgramCounter().get() < program.size()){
+        cpu.step(cpu);
+    }
+    return cpu.getRegisterFile().read(16);
+}
+
+int main(){
+    ALU alu;
+    StatusRegister sr;
+
+    //SBC/CPC keep Z from the lower byte only when their own byte is zero
+    sr.set(FLAG_Z);
+    alu.subCarry(0x00, 0x00, sr);
+    check(sr.getFlag(FLAG_Z), "Z stays set for a zero byte after a zero byte");
+
+    sr.set(0);
+    alu.subCarry(0x00, 0x00, sr);
+    check(!sr.getFlag(FLAG_Z), "Z is not set by a zero byte after a non-zero byte");
+
+    sr.set(FLAG_Z);
+    alu.subCarry(0x01, 0x00, sr);
+    check(!sr.getFlag(FLAG_Z), "Z is cleared by a non-zero byte");
+
+    sr.set(FLAG_Z | FLAG_C);
+    uint8_t result = alu.subCarry(0x01, 0x00, sr);
+    check(result == 0x00 && !sr.getFlag(FLAG_C), "Carry is borrowed");
+    check(sr.getFlag(FLAG_Z), "Borrowed to zero keeps Z");
+
+    //0x0001 vs 0x0000: only the low bytes differ, CPC must not set Z again
+    check(runCompare(compare16(0x01, 0x00, 0x00, 0x00), false) == 1, "CP/CPC 0x0001 != 0x0000");
+    check(runCompare(compare16(0x01, 0x00, 0x00, 0x00), true) == 1, "Fused CP/CPC 0x0001 != 0x0000");
+    check(runCompare(compare16(0x00, 0x01, 0x00, 0x00), false) == 1, "CP/CPC 0x0100 != 0x0000");
+    check(runCompare(compare16(0x00, 0x01, 0x00, 0x00), true) == 1, "Fused CP/CPC 0x0100 != 0x0000");
+    check(runCompare(compare16(0x34, 0x12, 0x34, 0x12), false) == 0, "CP/CPC 0x1234 == 0x1234");
+    check(runCompare(compare16(0x34, 0x12, 0x34, 0x12), true) == 0, "Fused CP/CPC 0x1234 == 0x1234");
+
+    return report();
+}
@@ -0,0 +1,68 @@
+#include "avr_emu.h"
+#include "Check.hpp"
+#include <cstring>
+
+struct Host {
+    uint16_t lastAddr = 0;
+    uint8_t lastValue = 0;
+    int writes = 0;
+    int stopAfter = 0; //Stop the run on this write, 0 = never
+};
+
+static uint8_t hostRead(void*, uint16_t, uint64_t){
+    return 0x99;
+}
+
+static int hostWrite(void* user, uint16_t addr, uint8_t value, uint64_t){
+    Host* host = static_cast<Host*>(user);
+    host->lastAddr = addr;
+    host->lastValue = value;
+    host->writes++;
+    return host->writes == host->stopAfter;
+}
+
+//Load, run to a PC inside a fused LDI pair, and talk to the host through GPIOR0
+int main(){
+    const uint16_t program[] = {
+        0xE402, // ldi r16,0x42
+        0xBB0E, // out GPIOR0,r16
+        0xB31E, // in r17,GPIOR0
+        0xE021, // ldi r18,1
+        0xE032, // ldi r19,2        fused with the LDI above
+        0xBB0E, // out GPIOR0,r16
+        0xF7FF  // brid .-1
+    };
+    avr_emu* emu = avr_create();
+    check(emu != nullptr, "create");
+    check(avr_load_flash(emu, program, sizeof(program) / sizeof(program[0])) == 0, "load");
+
+    Host host;
+    check(avr_set_io_callbacks(emu, 0x3E, 0x3E, hostRead, hostWrite, &host) == 0, "callbacks on GPIOR0");
+    check(avr_set_io_callbacks(emu, 0x10, 0x10, hostRead, hostWrite, &host) != 0, "registers are not I/O");
+
+    check(avr_run_until_pc(emu, 4, 100) == AVR_HIT_PC, "stops at the PC");
+    check(*avr_pc(emu) == 4, "PC view shows the target");
+    uint8_t* regs = avr_regs(emu);
+    check(regs[18] == 1 && regs[19] == 0, "fused pair split at the target");
+    check(host.writes == 1 && host.lastAddr == 0x3E && host.lastValue == 0x42, "OUT reaches the write callback");
+    check(regs[17] == 0x99, "IN returns what the read callback gave");
+
+    host.stopAfter = 2;
+    check(avr_run_cycles(emu, 100) == AVR_STOPPED, "a nonzero write callback stops the run");
+    check(*avr_pc(emu) == 6 && regs[19] == 2, "stopped right after the OUT");
+    uint64_t before = avr_cycles(emu);
+    check(avr_run_cycles(emu, 10) == AVR_OK && avr_cycles(emu) >= before + 10, "runs for the cycle budget");
+
+    //Patch the spin into an unsupported word; the error comes back as a status
+    avr_flash(emu)[6] = 0xFFFF;
+    check(avr_flash_changed(emu) == 0, "flash changed");
+    check(avr_run_until_pc(emu, 0, 100) == AVR_ILLEGAL_OPCODE, "illegal opcode status");
+    check(std::strlen(avr_last_error(emu)) > 0, "error text is kept");
+
+    avr_reset(emu);
+    check(*avr_pc(emu) == 0 && avr_cycles(emu) == 0, "reset");
+    check(avr_run_until_pc(emu, 4, 100) == AVR_HIT_PC && regs[18] == 1, "runs again after a failed run");
+    avr_destroy(emu);
+
+    return report();
+}
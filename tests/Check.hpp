@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdio>
+
+//Each test is one executable: failed checks are printed and counted, and main
+//returns the result of report()
+static int failures = 0;
+
+static void check(bool ok, const char* what){
+    if(!ok){
+        std::printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static int report(){
+    if(failures == 0){
+        std::printf("ok\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#include "CoSimulator.hpp"
+#include "Check.hpp"
+
+//Bytes written to UDR0 on one MCU are read from UDR0 on the other, one link
+//latency later
+int main(){
+    Flash senderFlash;
+    senderFlash.load({
+        0xECE6, // ldi r30,0xC6
+        0xE0F0, // ldi r31,0x00      Z = UDR0
+        0xE401, // ldi r16,0x41
+        0x8300, // st Z,r16
+        0xE402, // ldi r16,0x42
+        0x8300, // st Z,r16
+        0xF7FF  // brid .-1 (I is clear: spin)
+    });
+    Flash receiverFlash;
+    receiverFlash.load({
+        0xECE0, // ldi r30,0xC0
+        0xE0F0, // ldi r31,0x00      Z = UCSR0A
+        0x8100, // ld r16,Z
+        0x7800, // andi r16,0x80     RXC0
+        0xF3E9, // breq .-3
+        0x8116, // ldd r17,Z+6       UDR0
+        0x8100, // ld r16,Z
+        0x7800, // andi r16,0x80
+        0xF3E9, // breq .-3
+        0x8126, // ldd r18,Z+6
+        0xF7FF  // brid .-1
+    });
+    SRAM senderSram;
+    CPU sender(&senderFlash, &senderSram);
+    SRAM receiverSram;
+    CPU receiver(&receiverFlash, &receiverSram);
+
+    CoSimulator sim;
+    size_t a = sim.addMcu(&sender);
+    size_t b = sim.addMcu(&receiver);
+    sim.connect(a, b, 100);
+
+    bool rejected = false;
+    try{
+        sim.connect(a, b, 100);
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    check(rejected, "a USART0 feeds a single link");
+
+    sim.run(50);
+    check(receiver.getRegisterFile().read(17) == 0, "nothing arrives before the latency");
+    sim.run(500);
+    check(receiver.getRegisterFile().read(17) == 0x41, "first byte crosses the link");
+    check(receiver.getRegisterFile().read(18) == 0x42, "second byte crosses the link");
+
+    return report();
+}
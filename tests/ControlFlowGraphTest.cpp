@@ -0,0 +1,73 @@
+#include "ControlFlowGraph.hpp"
+#include "Check.hpp"
+
+static bool isBlock(const BasicBlock* block, uint16_t start, uint16_t end, BlockExit exit, uint16_t taken, uint16_t next){
+    return block && block->start == start && block->end == end && block->exit == exit
+        && block->taken == taken && block->next == next;
+}
+
+//Blocks, skips over one- and two-word instructions and counted loops on a
+//hand-assembled image
+int main(){
+    const uint16_t image[] = {
+        0xE005,         // 0  ldi r16,5
+        0xE180,         // 1  ldi r24,0x10
+        0xE092,         // 2  ldi r25,0x02
+        0x950A,         // 3  dec r16           loop: 5 iterations
+        0xF7F1,         // 4  brne .-4
+        0x9110, 0x0100, // 5  lds r17,0x0100
+        0x1310,         // 7  cpse r17,r16      skips the two-word JMP
+        0x940C, 0x000C, // 8  jmp 12
+        0xFD10,         // 10 sbrc r17,0
+        0x9513,         // 11 inc r17
+        0xE28C,         // 12 ldi r24,0x2C
+        0xE091,         // 13 ldi r25,0x01
+        0x9701,         // 14 sbiw r24,1        loop: 0x012C iterations
+        0xF7F1,         // 15 brne .-4
+        0xCFFF,         // 16 rjmp .-2          idle
+        0xFFFF          // 17 data
+    };
+    ControlFlowGraph cfg;
+    cfg.build(image, sizeof(image) / sizeof(image[0]));
+
+    check(cfg.getBlocks().size() == 9, "nine blocks");
+    check(isBlock(cfg.blockAt(0), 0, 3, BlockExit::FallThrough, NO_TARGET, 3), "entry block falls into the loop head");
+    check(cfg.blockAt(0)->instructions == 3, "entry block holds three instructions");
+    check(isBlock(cfg.blockAt(3), 3, 5, BlockExit::Branch, 3, 5), "DEC/BRNE loop branches to itself");
+    check(isBlock(cfg.blockAt(5), 5, 8, BlockExit::Skip, 10, 8), "CPSE skips both words of JMP");
+    check(cfg.blockAt(6) == cfg.blockAt(5) && cfg.blockAt(5)->instructions == 2, "LDS counts once and covers two words");
+    check(isBlock(cfg.blockAt(8), 8, 10, BlockExit::Jump, 12, NO_TARGET), "JMP takes its target from the second word");
+    check(isBlock(cfg.blockAt(10), 10, 11, BlockExit::Skip, 12, 11), "SBRC skips a one-word instruction");
+    check(isBlock(cfg.blockAt(11), 11, 12, BlockExit::FallThrough, NO_TARGET, 12), "skipped instruction is its own block");
+    check(isBlock(cfg.blockAt(12), 12, 14, BlockExit::FallThrough, NO_TARGET, 14), "jump and skip targets start a block");
+    check(isBlock(cfg.blockAt(14), 14, 16, BlockExit::Branch, 14, 16), "SBIW/BRNE loop branches to itself");
+    check(isBlock(cfg.blockAt(16), 16, 17, BlockExit::Jump, 16, NO_TARGET), "RJMP .-2 jumps to itself");
+    check(cfg.blockAt(17) == nullptr, "unreachable data belongs to no block");
+
+    check(cfg.getInstructionCount() == 15, "fifteen reachable instructions");
+    check(cfg.isSecondWord(6) && cfg.isSecondWord(9), "LDS and JMP second words are marked");
+    check(!cfg.isInstructionStart(6) && !cfg.isInstructionStart(9), "second words are not instruction starts");
+    check(cfg.isInstructionStart(7) && cfg.isInstructionStart(10), "instructions after two-word ones start on the right word");
+    check(cfg.getCallTargets().empty(), "no calls");
+
+    check(cfg.isIdleLoop(16), "self jump is an idle loop");
+    check(!cfg.isIdleLoop(3) && !cfg.isIdleLoop(14), "counted loops are not idle");
+
+    check(cfg.getLoops().size() == 2, "two counted loops");
+    const CountedLoop* dec = cfg.loopAt(3);
+    check(dec && dec->branch == 4 && dec->reg == 16 && dec->iterations == 5, "DEC loop counts r16 from its LDI");
+    const CountedLoop* sbiw = cfg.loopAt(14);
+    check(sbiw && sbiw->branch == 15 && sbiw->reg == 24 && sbiw->iterations == 0x012C, "SBIW loop counts r25:r24 from the LDIs before it");
+
+    //An LDI of zero runs the full range
+    uint16_t wrapped[] = {0xE000, 0x950A, 0xF7F1}; //ldi r16,0 ; dec r16 ; brne .-4
+    cfg.build(wrapped, 3);
+    check(cfg.loopAt(1) && cfg.loopAt(1)->iterations == 256, "a zero counter loops 256 times");
+
+    //The counter touched inside the body is not a counted loop
+    uint16_t clobbered[] = {0xE005, 0x9503, 0x950A, 0xF7E9}; //ldi r16,5 ; inc r16 ; dec r16 ; brne .-6
+    cfg.build(clobbered, 4);
+    check(cfg.getLoops().empty(), "a counter written in the body is rejected");
+
+    return report();
+}
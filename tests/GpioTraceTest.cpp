@@ -0,0 +1,77 @@
+#include "cpu.hpp"
+#include "Gpio.hpp"
+#include "VcdWriter.hpp"
+#include "Check.hpp"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+static std::string slurp(const std::string& path){
+    std::ifstream in(path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool contains(const std::string& text, const std::string& part){
+    return text.find(part) != std::string::npos;
+}
+
+//PINx writes toggle PORTx, and every level change reaches the VCD
+int main(){
+    Flash flash;
+    flash.load({
+        0xE003, // ldi r16,0x03
+        0xB904, // out DDRB,r16      PB0, PB1 outputs
+        0xE001, // ldi r16,0x01
+        0xB903, // out PINB,r16      toggle PB0 on
+        0xB903, // out PINB,r16      and off again
+        0xE002, // ldi r16,0x02
+        0xB903  // out PINB,r16      toggle PB1 on
+    });
+    SRAM sram;
+    CPU cpu(&flash, &sram);
+    Gpio gpio;
+    gpio.attach(&cpu.getSRAM());
+    gpio.setInput(2, 0x80); //PD7 pulled high from outside
+    PinEventRing ring;
+    gpio.setTrace(&ring);
+
+    std::string path = "gpio_trace_test_" + std::to_string(getpid()) + ".vcd";
+    {
+        VcdWriter writer(&ring, gpio, path);
+        writer.start();
+
+        cpu.runInstructions(cpu, 4);
+        check(gpio.getLevel(0) == 0x01, "writing PINB toggles PB0 on");
+        check(cpu.getSRAM().read(PORTB) == 0x01, "the toggle lands in PORTB");
+        cpu.runInstructions(cpu, 1);
+        check(gpio.getLevel(0) == 0x00, "a second toggle turns PB0 off");
+        cpu.runInstructions(cpu, 2);
+        check(gpio.getLevel(0) == 0x02, "only the written bit toggles");
+        check(cpu.getSRAM().read(PINB) == 0x02, "PINB reads the pin levels");
+        writer.stop();
+    }
+    std::string vcd = slurp(path);
+    check(contains(vcd, "$var wire 8 ! PINB $end"), "ports are named after the pin registers");
+    check(contains(vcd, "$dumpvars\nb00000000 !\nb00000000 \"\nb10000000 #\n$end"), "dump starts from the current levels");
+    check(contains(vcd, "b00000001 !"), "PB0 rising edge is traced");
+    check(contains(vcd, "b00000010 !"), "PB1 rising edge is traced");
+    check(!contains(vcd, "dropped"), "no drops noted when the ring kept up");
+    std::remove(path.c_str());
+
+    //A ring nobody drains overflows; the writer notes the gap
+    PinEventRing full;
+    for(size_t i = 0; i < RING_SIZE + 5; i++){
+        full.push({i, 0, static_cast<uint8_t>(i)});
+    }
+    {
+        VcdWriter writer(&full, gpio, path);
+        writer.start();
+        writer.stop();
+    }
+    vcd = slurp(path);
+    check(contains(vcd, "$comment 5 pin events dropped $end"), "drops are written to the VCD");
+    std::remove(path.c_str());
+
+    return report();
+}
@@ -0,0 +1,114 @@
+#include "ImageCache.hpp"
+#include "Check.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static std::vector<std::string> cacheFiles(const std::string& dir){
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+    if(!d) return files;
+    while(dirent* entry = readdir(d)){
+        std::string name = entry->d_name;
+        if(name != "." && name != "..") files.push_back(dir + "/" + name);
+    }
+    closedir(d);
+    return files;
+}
+
+static bool sameTables(const DecodeTable& a, const FusionTable& fa, const DecodeTable& b, const FusionTable& fb){
+    if(fa.count() != fb.count()) return false;
+    for(uint16_t addr = 0; addr < WORDS; addr++){
+        if(a.at(addr) != b.at(addr)) return false;
+        const FusedOp* x = fa.at(addr);
+        const FusedOp* y = fb.at(addr);
+        if((x == nullptr) != (y == nullptr)) return false;
+        if(x && (x->kind != y->kind || x->a != y->a || x->b != y->b || x->offset != y->offset)) return false;
+    }
+    return true;
+}
+
+//Store on a miss, map back on a hit, and never trust a damaged file
+int main(){
+    std::string dir = "image_cache_test_" + std::to_string(getpid());
+    Flash flash;
+    flash.load({
+        0xE020, // ldi r18,0x00
+        0xE030, // ldi r19,0x00      LDI pair
+        0x5021, // subi r18,1
+        0x4030, // sbci r19,0        SUBI/SBCI pair
+        0x9701, // sbiw r24,1
+        0xF7F1  // brne .-4          SBIW/BRNE pair
+    });
+    InstructionDecoder decoder;
+    DecodeTable built;
+    FusionTable builtFusion;
+    built.build(flash, decoder);
+    builtFusion.build(flash);
+
+    {
+        ImageCache cache(dir);
+        DecodeTable decode;
+        FusionTable fusion;
+        check(!cache.prepare(flash, decoder, decode, fusion), "first load is a miss");
+        check(cacheFiles(dir).size() == 1, "the miss stores one file and no temporaries");
+        check(sameTables(decode, fusion, built, builtFusion), "miss builds the tables");
+        check(cache.mappedImages() == 0, "built tables need no mapping");
+    }
+
+    ImageCache cache(dir);
+    DecodeTable decode;
+    FusionTable fusion;
+    check(cache.prepare(flash, decoder, decode, fusion), "second load is a hit");
+    check(sameTables(decode, fusion, built, builtFusion), "hit maps the same tables");
+    for(int i = 0; i < 5; i++){
+        cache.prepare(flash, decoder, decode, fusion);
+    }
+    check(cache.mappedImages() == 1, "reloading replaces the mapping instead of adding one");
+    DecodeTable other;
+    FusionTable otherFusion;
+    cache.prepare(flash, decoder, other, otherFusion);
+    check(cache.mappedImages() == 2, "each table owner has its own mapping");
+
+    Flash changed;
+    changed.load({0xE021, 0xE030});
+    check(!cache.prepare(changed, decoder, other, otherFusion), "another image is a miss");
+    check(cache.mappedImages() == 1, "rebuilt tables release their old mapping");
+    check(cacheFiles(dir).size() == 2, "one file per image");
+
+    //Damage the header of the first image's file: it is rejected and rewritten
+    std::string path;
+    for(const std::string& file : cacheFiles(dir)){
+        std::FILE* f = std::fopen(file.c_str(), "rb");
+        CacheHeader header;
+        bool read = f && std::fread(&header, sizeof(header), 1, f) == 1;
+        if(f) std::fclose(f);
+        if(read && header.imageHash == ImageCache::imageHash(flash)) path = file;
+    }
+    check(!path.empty(), "cache file is named after the image");
+    std::FILE* f = std::fopen(path.c_str(), "r+b");
+    uint32_t bad = 0xFFFFFFFF;
+    std::fseek(f, offsetof(CacheHeader, version), SEEK_SET);
+    std::fwrite(&bad, sizeof(bad), 1, f);
+    std::fclose(f);
+    DecodeTable fresh;
+    FusionTable freshFusion;
+    check(!cache.prepare(flash, decoder, fresh, freshFusion), "corrupted header is a miss");
+    check(sameTables(fresh, freshFusion, built, builtFusion), "tables are rebuilt after a rejected file");
+    check(cache.prepare(flash, decoder, fresh, freshFusion), "the rewritten file is used again");
+
+    //A file cut short is rejected too
+    truncate(path.c_str(), sizeof(CacheHeader) + 16);
+    DecodeTable cut;
+    FusionTable cutFusion;
+    check(!cache.prepare(flash, decoder, cut, cutFusion), "truncated file is a miss");
+
+    for(const std::string& file : cacheFiles(dir)){
+        std::remove(file.c_str());
+    }
+    rmdir(dir.c_str());
+    return report();
+}
@@ -0,0 +1,126 @@
+#include "cpu.hpp"
+#include "DiffChecker.hpp"
+#include "InputRecorder.hpp"
+#include "InputReplayer.hpp"
+#include "Check.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+static constexpr uint64_t RUN_CYCLES = 20000;
+
+//Copies every USART0 byte to 0x0200.. and sums PINB into r19
+static void loadFirmware(Flash& flash){
+    flash.load({
+        0xE0A0, // ldi r26,0x00
+        0xE0B2, // ldi r27,0x02      X = 0x0200
+        0xECE0, // ldi r30,0xC0
+        0xE0F0, // ldi r31,0x00      Z = UCSR0A
+        0x8100, // ld r16,Z
+        0x7800, // andi r16,0x80     RXC0
+        0xF019, // breq .+6
+        0x8116, // ldd r17,Z+6       UDR0
+        0x931D, // st X+,r17
+        0xB123, // in r18,PINB
+        0x0F32, // add r19,r18
+        0xCFF7  // rjmp .-18
+    });
+}
+
+//One target instance with its peripherals
+struct Board {
+    Flash flash;
+    SRAM sram;
+    CPU cpu;
+    Gpio gpio;
+    Usart usart;
+    UsartInput rx;
+    InputSinks sinks;
+
+    Board() : cpu(&flash, &sram){
+        loadFirmware(flash);
+        gpio.attach(&cpu.getSRAM());
+        usart.attach(&cpu.getSRAM());
+        rx.attach(&usart);
+        sinks.gpio = &gpio;
+        sinks.usart = &rx;
+    }
+
+    ~Board(){
+        cpu.getSRAM().detach(&gpio);
+        cpu.getSRAM().detach(&usart);
+    }
+
+    uint64_t hash(){
+        return DiffChecker::hash(cpu.getState());
+    }
+};
+
+//Runs with the host delivering bytes and pin levels at odd points in time
+static uint64_t record(InputLog* log){
+    Board board;
+    InputRecorder recorder(&board.cpu, board.sinks, log);
+    uint64_t nextInput = 137;
+    uint8_t byte = 'a';
+    while(board.cpu.getCycles() < RUN_CYCLES){
+        if(log && board.cpu.getCycles() >= nextInput){
+            recorder.usartRx(0, byte++);
+            if(byte % 3 == 0) recorder.usartRx(0, byte++); //Two at once queue up
+            recorder.pinChange(0, byte);
+            nextInput += 911 + byte;
+        }
+        board.cpu.step(board.cpu);
+    }
+    return board.hash();
+}
+
+static uint64_t replay(const InputLog& log, uint64_t& stored){
+    Board board;
+    InputReplayer replayer(&log, board.sinks);
+    board.cpu.getSRAM().addDevice(&replayer);
+    replayer.run(board.cpu, RUN_CYCLES, UINT64_MAX, nullptr);
+    check(replayer.finished(), "replay delivers every event");
+    const uint8_t* regs = board.cpu.getState().regs.data();
+    stored = regs[26] | regs[27] << 8;
+    uint64_t hash = board.hash();
+    board.cpu.getSRAM().detach(&replayer);
+    return hash;
+}
+
+//Recording and replaying the same inputs must end in the same state
+int main(){
+    InputLog log;
+    uint64_t recorded = record(&log);
+    check(log.size() > 10, "inputs were recorded");
+    check(recorded != record(nullptr), "the inputs change the final state");
+
+    uint64_t stored = 0;
+    check(replay(log, stored) == recorded, "replay reaches the recorded state");
+    check(stored > 0x0200 + 10, "USART bytes reached the firmware");
+
+    std::string path = "input_log_test_" + std::to_string(getpid()) + ".bin";
+    log.save(path);
+    InputLog loaded;
+    loaded.load(path);
+    check(loaded.size() == log.size() && loaded.byteSize() == log.byteSize(), "save and load keep every event");
+    check(replay(loaded, stored) == recorded, "a loaded log replays to the recorded state");
+
+    //An event count the file cannot hold is rejected before anything is decoded
+    std::FILE* f = std::fopen(path.c_str(), "r+b");
+    uint64_t huge = UINT64_MAX / 2;
+    std::fseek(f, 8, SEEK_SET);
+    std::fwrite(&huge, sizeof(huge), 1, f);
+    std::fclose(f);
+    bool rejected = false;
+    try{
+        loaded.load(path);
+    }catch(const std::runtime_error&){
+        rejected = true;
+    }
+    check(rejected, "inflated event count is rejected");
+    check(loaded.size() == log.size(), "a rejected load leaves the log as it was");
+    std::remove(path.c_str());
+
+    return report();
+}
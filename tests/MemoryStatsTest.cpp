@@ -0,0 +1,45 @@
+#include "cpu.hpp"
+#include "MemoryStats.hpp"
+#include "Check.hpp"
+
+//Data and stack traffic generated by firmware, not by the host
+int main(){
+    Flash flash;
+    flash.load({
+        0xE0A0, // ldi r26,0x00
+        0xE0B1, // ldi r27,0x01      X = 0x0100
+        0xE402, // ldi r16,0x42
+        0x930D, // st X+,r16
+        0x911E, // ld r17,-X
+        0xE008, // ldi r16,0x08
+        0xBF0E, // out SPH,r16
+        0xEF0F, // ldi r16,0xFF
+        0xBF0D, // out SPL,r16       SP = 0x08FF
+        0x931F, // push r17
+        0x931F, // push r17
+        0x912F  // pop r18
+    });
+    SRAM sram;
+    CPU cpu(&flash, &sram);
+    MemoryStats stats;
+    cpu.setMemoryStats(&stats);
+
+    cpu.runInstructions(cpu, 12);
+
+    RegisterFile& regs = cpu.getRegisterFile();
+    check(regs.read(17) == 0x42, "LD reads the byte ST wrote");
+    check(regs.read(18) == 0x42, "POP returns the pushed byte");
+    check(regs.read(26) == 0x00 && regs.read(27) == 0x01, "X is back at 0x0100");
+    check(cpu.getStackPointer() == 0x08FE, "SP after two pushes and a pop");
+
+    check(stats.wasWritten(0x0100), "ST marks its target as written");
+    check(stats.getWrites(0x0100 / PAGE_BYTES) == 1, "ST counts one write on its page");
+    check(stats.getReads(0x0100 / PAGE_BYTES) == 1, "LD counts one read on its page");
+    check(stats.wasWritten(0x08FF) && stats.wasWritten(0x08FE), "PUSH marks stack bytes as written");
+    check(stats.getStackLow() == 0x08FD, "Stack low-water mark follows PUSH");
+    check(stats.getPeakStackDepth() == 2, "Peak stack depth");
+    const std::vector<StackLow>& lows = stats.getStackLows();
+    check(lows.size() == 2 && lows[0].sp == 0x08FE && lows[1].sp == 0x08FD, "Each new low is recorded once, POP adds none");
+
+    return report();
+}
@@ -0,0 +1,40 @@
+#include "DiffChecker.hpp"
+#include "OpcodeGenerator.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static constexpr uint32_t SEEDS[] = {1, 2, 3, 4};
+static constexpr size_t PROGRAMS = 8;
+static constexpr uint64_t INSTRUCTIONS = 50000;
+static constexpr uint64_t MIN_MEAN_RETIRED = 2000;
+
+//Fixed-seed soak: the reference and optimized engines agree on random programs,
+//and the programs run long enough for that to mean something
+int main(){
+    InstructionDecoder decoder;
+    OpcodeGenerator generator(&decoder, 1);
+    bool accepted = true;
+    for(int i = 0; i < 100000; i++){
+        accepted = accepted && decoder.accepts(generator.next());
+    }
+    check(accepted, "every generated word is one its decoder accepts");
+    std::vector<uint16_t> program = generator.program(64);
+    check(std::equal(PROLOGUE, PROLOGUE + PROLOGUE_WORDS, program.begin()), "programs start with the common prologue");
+
+    for(uint32_t seed : SEEDS){
+        Divergence divergence;
+        SoakStats stats;
+        bool agreed = DiffChecker::soak(seed, PROGRAMS, INSTRUCTIONS, divergence, stats);
+        if(!agreed){
+            std::printf("seed %u: diverged after %llu instructions at pc 0x%04x\n%s", seed,
+                        static_cast<unsigned long long>(divergence.instruction), divergence.pc, divergence.detail.c_str());
+        }
+        check(agreed, "engines agree on every program");
+        check(stats.programs == PROGRAMS, "every program ran");
+        check(stats.fewestRetired > PROLOGUE_WORDS, "every program gets past its start-up code");
+        check(stats.totalRetired / PROGRAMS >= MIN_MEAN_RETIRED, "programs retire enough instructions on average");
+    }
+    return report();
+}
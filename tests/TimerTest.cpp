@@ -0,0 +1,76 @@
+#include "Timer.hpp"
+#include "Check.hpp"
+
+//Timer0 driven straight through its registers; clock is the CPU cycle count
+int main(){
+    uint64_t clock = 0;
+
+    //Normal mode, no prescaling: TCNT follows the clock and wraps with TOV
+    Timer normal(TIMER0);
+    normal.setClock(&clock);
+    normal.write(TIMER0.tccrb, 0x01);
+    clock = 100;
+    check(normal.read(TIMER0.tcnt) == 100, "TCNT counts one per cycle");
+    check((normal.read(TIMER0.tifr) & TOV) == 0, "no overflow before MAX");
+    clock = 256;
+    normal.sync(clock);
+    check(normal.read(TIMER0.tcnt) == 0, "TCNT wraps after MAX");
+    check(normal.read(TIMER0.tifr) & TOV, "TOV is set on the wrap");
+    normal.write(TIMER0.tifr, TOV);
+    check((normal.read(TIMER0.tifr) & TOV) == 0, "writing a one clears TOV");
+
+    //Deadline: whole ticks of the prescaler, minus the cycles already counted
+    Timer slow(TIMER0);
+    clock = 0;
+    slow.setClock(&clock);
+    slow.write(TIMER0.tccrb, 0x02); //clk/8
+    check(slow.nextDeadline() == UINT64_MAX, "no deadline while interrupts are off");
+    slow.write(TIMER0.timsk, TOV);
+    check(slow.nextDeadline() == 2048, "overflow after 256 ticks of 8 cycles");
+    clock = 5;
+    slow.sync(clock);
+    check(slow.nextDeadline() == 2048, "a partial tick does not move the deadline");
+    clock = 2047;
+    slow.sync(clock);
+    check((slow.read(TIMER0.tifr) & TOV) == 0, "not yet overflowed one cycle early");
+    clock = 2048;
+    slow.sync(clock);
+    check(slow.read(TIMER0.tifr) & TOV, "overflowed at the deadline");
+    check(slow.nextDeadline() == UINT64_MAX, "a pending flag needs no deadline");
+
+    //CTC: OCF0A one tick after TCNT reaches OCR0A, then back to BOTTOM
+    Timer ctc(TIMER0);
+    clock = 0;
+    ctc.setClock(&clock);
+    ctc.write(TIMER0.ocra, 9);
+    ctc.write(TIMER0.tccra, 0x02);
+    ctc.write(TIMER0.timsk, OCFA);
+    ctc.write(TIMER0.tccrb, 0x01);
+    check(ctc.nextDeadline() == 10, "OCF0A deadline is OCR0A + 1");
+    clock = 9;
+    check(ctc.read(TIMER0.tcnt) == 9 && (ctc.read(TIMER0.tifr) & OCFA) == 0, "match count reached, flag not yet");
+    clock = 10;
+    check(ctc.read(TIMER0.tcnt) == 0, "CTC clears TCNT after the match");
+    check(ctc.read(TIMER0.tifr) & OCFA, "OCF0A set after the match");
+    check(ctc.interruptPending(), "enabled flag is pending");
+
+    //TCNT written above TOP runs on to MAX and still matches OCR0B on the way
+    Timer above(TIMER0);
+    clock = 0;
+    above.setClock(&clock);
+    above.write(TIMER0.ocra, 9);
+    above.write(TIMER0.ocrb, 220);
+    above.write(TIMER0.tccra, 0x02);
+    above.write(TIMER0.tcnt, 200);
+    above.write(TIMER0.timsk, OCFB);
+    above.write(TIMER0.tccrb, 0x01);
+    check(above.nextDeadline() == 21, "OCF0B deadline between TCNT and MAX");
+    clock = 20;
+    check((above.read(TIMER0.tifr) & OCFB) == 0, "OCF0B not set before the match");
+    clock = 21;
+    check(above.read(TIMER0.tifr) & OCFB, "OCF0B set above TOP");
+    clock = 56;
+    check(above.read(TIMER0.tcnt) == 0 && (above.read(TIMER0.tifr) & TOV), "wraps at MAX with TOV");
+
+    return report();
+}